@@ -0,0 +1,151 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: implementation of class ~atkinProducer~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Alg/atkinProducer.hpp"
+#include "Alg/eratSieve.hpp"
+#include "Utils/num.hpp"
+
+#include <cstdint>
+
+using namespace std;
+using namespace Utils;
+
+namespace Alg {
+
+namespace {
+
+// Form whose number of solutions tells whether a number of each
+// residue modulo 60 is prime: 1 for 4x^2 + y^2, 2 for 3x^2 + y^2, 3
+// for 3x^2 - y^2, and 0 for the residues that are not coprime to 60.
+const uint8_t kformOf[60] = {
+  0, 1, 0, 0, 0, 0, 0, 2, 0, 0, 0, 3, 0, 1, 0, 0, 0, 1, 0, 2,
+  0, 0, 0, 3, 0, 0, 0, 0, 0, 1, 0, 2, 0, 0, 0, 0, 0, 1, 0, 0,
+  0, 1, 0, 2, 0, 0, 0, 3, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0, 0, 3
+};
+
+inline bool isCoprimeToWheel(const uint64_t n)
+{
+  return n % 2 != 0 && n % 3 != 0 && n % 5 != 0;
+}
+
+}
+
+template <typename primeType>
+constexpr unsigned atkinProducer<primeType>::kformsMod;
+
+template <typename primeType>
+atkinProducer<primeType>::atkinProducer()
+  : sievingPrimes(nullptr), numSievingPrimes(0)
+{}
+
+template <typename primeType>
+void atkinProducer<primeType>::start(const primeType* sievingPrimes,
+                                     const size_t numSievingPrimes)
+  noexcept(false)
+{
+  this->sievingPrimes = sievingPrimes;
+  this->numSievingPrimes = numSievingPrimes;
+}
+
+template <typename primeType>
+void atkinProducer<primeType>::produce(DS::wheelSegment& segment,
+                                       const primeType leftLim,
+                                       const primeType rightLim)
+  noexcept(false)
+{
+  // Solutions of the first form have y odd, and those of the second
+  // form x odd and y even, since the number is odd, and 7 modulo 12.
+  segment.reset();
+  flipSum(segment, leftLim, rightLim, 4, 1, 1, 1, 1);
+  flipSum(segment, leftLim, rightLim, 3, 1, 2, 2, 2);
+  flipDifference(segment, leftLim, rightLim);
+
+  // Marked now: what had an even number of solutions.
+  segment.flipAll();
+  for (size_t i = 0; i < numSievingPrimes; ++i) {
+    const primeType square = sievingPrimes[i] * sievingPrimes[i];
+    if (square >= rightLim) {
+      break;
+    }
+
+    const primeType rest = leftLim % square;
+    if (rest != 0 && square - rest >= rightLim - leftLim) {
+      continue;
+    }
+    for (primeType n = leftLim + (rest != 0 ? square - rest : 0);;
+         n += square) {
+      if (isCoprimeToWheel(n)) {
+        segment.mark(DS::wheelSegment::offsetToBit(n - leftLim));
+      }
+      if (rightLim - n <= square) {
+        break;
+      }
+    }
+  }
+}
+
+template <typename primeType>
+void atkinProducer<primeType>::flipSum(DS::wheelSegment& segment,
+                                       const primeType leftLim,
+                                       const primeType rightLim,
+                                       const unsigned a,
+                                       const primeType firstX,
+                                       const primeType stepX,
+                                       const primeType firstY,
+                                       const unsigned form)
+{
+  for (primeType x = firstX; a * x * x < rightLim; x += stepX) {
+    const primeType base = a * x * x;
+    primeType y = base >= leftLim ? 1 : ceilSqrt(leftLim - base);
+    if (y % 2 != firstY % 2) {
+      ++y;
+    }
+    for (primeType n = base + y * y; n < rightLim;
+         y += 2, n = base + y * y) {
+      if (kformOf[n % kformsMod] == form) {
+        segment.flip(DS::wheelSegment::offsetToBit(n - leftLim));
+      }
+    }
+  }
+}
+
+template <typename primeType>
+void atkinProducer<primeType>::flipDifference(DS::wheelSegment& segment,
+                                              const primeType leftLim,
+                                              const primeType rightLim)
+{
+  // The largest number of x is 3x^2 - 1, and the smallest one
+  // 3x^2 - (x - 1)^2. x and y have different parities, since the
+  // number is 11 modulo 12.
+  primeType x = num<primeType>::max(ceilSqrt(leftLim / 3 + 1), 2);
+  for (; 2 * x * x + 2 * x - 1 < rightLim; ++x) {
+    const primeType base = 3 * x * x;
+    const primeType lastY = num<primeType>::min(
+      x - 1, num<primeType>::isqrt(base - leftLim));
+    primeType y = base >= rightLim ? ceilSqrt(base - rightLim + 1) : 1;
+    if ((x + y) % 2 == 0) {
+      ++y;
+    }
+    for (; y <= lastY; y += 2) {
+      const primeType n = base - y * y;
+      if (kformOf[n % kformsMod] == 3) {
+        segment.flip(DS::wheelSegment::offsetToBit(n - leftLim));
+      }
+    }
+  }
+}
+
+template <typename primeType>
+primeType atkinProducer<primeType>::ceilSqrt(const primeType n)
+{
+  const primeType root = num<primeType>::isqrt(n);
+  return root * root < n ? root + 1 : root;
+}
+
+template class atkinProducer<primeT>;
+
+}
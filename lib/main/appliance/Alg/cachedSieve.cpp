@@ -0,0 +1,283 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: implementation of class ~cachedSieve~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Alg/cachedSieve.hpp"
+
+#include "DS/wheelSegment.hpp"
+#include "Utils/num.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace Utils;
+
+namespace Alg {
+
+namespace {
+
+// Writes the primes of a run of blocks into the cache, as they are
+// listed. They come in order, so each block is put together on its
+// own and stored as soon as the next one is reached.
+class blockWriter : public primeSink<primeT> {
+public:
+  blockWriter(DS::primeCache* cache, const uint64_t firstBlock,
+              const uint64_t lastBlock)
+    : cache(cache), curBlock(firstBlock), lastBlock(lastBlock),
+      block(DS::primeCache::kblockBytes), count(0)
+  {}
+
+  void start(const primeT, const primeT) override
+  {
+    startBlock();
+  }
+
+  void consume(vector<primeT>& primes) override
+  {
+    const primeT span = DS::primeCache::blockSpan();
+    for (const primeT prime : primes) {
+      // The wheel primes have no bit.
+      if (prime < kminBitPrime) {
+        continue;
+      }
+      while (prime / span > curBlock) {
+        storeBlock();
+        startBlock();
+      }
+      const size_t bit =
+        DS::wheelSegment::offsetToBit(prime - curBlock * span);
+      block.data()[bit / 8] &= ~(1 << bit % 8);
+      ++count;
+    }
+  }
+
+  void finish() override
+  {
+    storeBlock();
+    while (curBlock <= lastBlock) {
+      startBlock();
+      storeBlock();
+    }
+  }
+
+private:
+  static constexpr primeT kminBitPrime = 7;
+
+  DS::primeCache* cache;
+  uint64_t curBlock;
+  const uint64_t lastBlock;
+  DS::wheelSegment block;
+  uint32_t count;
+
+  // Every number starts out marked, and the primes get unmarked as
+  // they come. 1 stays marked.
+  void startBlock()
+  {
+    memset(block.data(), 0xff, block.numBytes());
+    count = 0;
+  }
+
+  void storeBlock()
+  {
+    cache->store(curBlock, block, count);
+    ++curBlock;
+  }
+};
+
+// Hands the primes of a sieve over to a sink that is already
+// started, and is finished by someone else.
+class continuedSink : public primeSink<primeT> {
+public:
+  explicit continuedSink(primeSink<primeT>* sink)
+    : sink(sink)
+  {}
+
+  void start(const primeT, const primeT) override
+  {}
+
+  void consume(vector<primeT>& primes) override
+  {
+    sink->consume(primes);
+  }
+
+  void finish() override
+  {}
+
+private:
+  primeSink<primeT>* sink;
+};
+
+}
+
+cachedSieve::cachedSieve(const cacheInfo* cinfo,
+                         const sieveConfig* config,
+                         const string& cachePath,
+                         const primeT userLeftLim,
+                         const primeT userRightLim,
+                         primeSink<primeT>* sink,
+                         uint64_t* numPrimes) noexcept(false)
+  : cinfo(cinfo), config(config), userLeftLim(userLeftLim),
+    userRightLim(userRightLim), sink(nullptr), numPrimesFound(0)
+{
+  if (config->rankLocalOutput) {
+    throw invalid_argument{
+      "The prime cache does not support output by rank"};
+  }
+
+  MPI_Comm_rank(config->comm, &myProcRank);
+  if (myProcRank == 0) {
+    if (!config->countOnly) {
+      this->sink = sink;
+    }
+    cache.reset(new DS::primeCache(cachePath));
+  }
+
+  if (this->sink != nullptr) {
+    this->sink->start(userLeftLim, userRightLim);
+  }
+  addSmallPrimes();
+
+  const primeT span = DS::primeCache::blockSpan();
+  const primeT cachedRightLim =
+    num<primeT>::min(userRightLim, DS::primeCache::limit() - 1);
+  if (userLeftLim <= cachedRightLim) {
+    const vector<uint64_t> gaps =
+      findGaps(userLeftLim / span, cachedRightLim / span);
+    for (size_t i = 0; i < gaps.size(); i += 2) {
+      sieveGap(gaps[i], gaps[i + 1]);
+    }
+    if (myProcRank == 0) {
+      readCached(userLeftLim, cachedRightLim);
+    }
+  }
+  if (userRightLim > cachedRightLim) {
+    sieveUncached(num<primeT>::max(userLeftLim, cachedRightLim + 1));
+  }
+
+  if (this->sink != nullptr) {
+    this->sink->finish();
+  }
+  *numPrimes = numPrimesFound;
+}
+
+void cachedSieve::addSmallPrimes() noexcept(false)
+{
+  if (myProcRank != 0) {
+    return;
+  }
+
+  vector<primeT> smallPrimes;
+  for (const primeT prime : {2, 3, 5}) {
+    if (prime >= userLeftLim && prime <= userRightLim) {
+      smallPrimes.push_back(prime);
+    }
+  }
+  numPrimesFound += smallPrimes.size();
+  if (sink != nullptr && !smallPrimes.empty()) {
+    sink->consume(smallPrimes);
+  }
+}
+
+vector<uint64_t> cachedSieve::findGaps(const uint64_t firstBlock,
+                                       const uint64_t lastBlock)
+  noexcept(false)
+{
+  vector<uint64_t> gaps;
+  if (myProcRank == 0) {
+    cache->reserve(lastBlock + 1);
+    for (uint64_t block = firstBlock; block <= lastBlock; ++block) {
+      if (cache->hasBlock(block)) {
+        continue;
+      }
+      if (!gaps.empty() && gaps.back() == block - 1) {
+        gaps.back() = block;
+      }
+      else {
+        gaps.push_back(block);
+        gaps.push_back(block);
+      }
+    }
+  }
+
+  uint64_t numGaps = gaps.size();
+  MPI_Bcast(&numGaps, 1, MPI_UINT64_T, 0, config->comm);
+  gaps.resize(numGaps);
+  MPI_Bcast(gaps.data(), numGaps, MPI_UINT64_T, 0, config->comm);
+  return gaps;
+}
+
+void cachedSieve::sieveGap(const uint64_t firstBlock,
+                           const uint64_t lastBlock) noexcept(false)
+{
+  // Whole blocks are sieved, even past the ends of the range, so
+  // that they can be stored.
+  sieveConfig listConfig = *config;
+  listConfig.countOnly = false;
+  unique_ptr<blockWriter> writer;
+  if (myProcRank == 0) {
+    writer.reset(new blockWriter(cache.get(), firstBlock, lastBlock));
+  }
+
+  const primeT span = DS::primeCache::blockSpan();
+  uint64_t numFound = 0;
+  eratSieve<primeT>(cinfo, &listConfig, firstBlock * span,
+                    (lastBlock + 1) * span - 1, writer.get(),
+                    &numFound);
+}
+
+void cachedSieve::readCached(const primeT leftLim,
+                             const primeT rightLim) noexcept(false)
+{
+  const primeT span = DS::primeCache::blockSpan();
+  DS::wheelSegment block(DS::primeCache::kblockBytes);
+  vector<primeT> primes;
+
+  for (uint64_t blockIdx = leftLim / span; blockIdx <= rightLim / span;
+       ++blockIdx) {
+    const primeT blockLeftLim = blockIdx * span;
+    const primeT from = num<primeT>::max(leftLim, blockLeftLim);
+    const primeT to = num<primeT>::min(rightLim,
+                                       blockLeftLim + span - 1);
+    if (sink == nullptr && from == blockLeftLim &&
+        to == blockLeftLim + span - 1) {
+      numPrimesFound += cache->getCount(blockIdx);
+      continue;
+    }
+
+    cache->load(blockIdx, &block);
+    const size_t firstBit =
+      DS::wheelSegment::offsetToBit(from - blockLeftLim);
+    const size_t lastBit =
+      DS::wheelSegment::offsetToBit(to - blockLeftLim + 1);
+    if (sink == nullptr) {
+      numPrimesFound += block.countUnmarked(firstBit, lastBit);
+      continue;
+    }
+
+    numPrimesFound +=
+      block.appendUnmarked(firstBit, lastBit, blockLeftLim, &primes);
+    if (primes.size() >= kchunkPrimes) {
+      sink->consume(primes);
+      primes.clear();
+    }
+  }
+
+  if (sink != nullptr && !primes.empty()) {
+    sink->consume(primes);
+  }
+}
+
+void cachedSieve::sieveUncached(const primeT leftLim) noexcept(false)
+{
+  continuedSink continued(sink);
+  uint64_t numFound = 0;
+  eratSieve<primeT>(cinfo, config, leftLim, userRightLim,
+                    sink != nullptr ? &continued : nullptr, &numFound);
+  numPrimesFound += numFound;
+}
+
+}
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: implementation of class ~eratProducer~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Alg/eratProducer.hpp"
+#include "Alg/eratSieve.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace Alg {
+
+template <typename primeType>
+eratProducer<primeType>::eratProducer(const size_t windowBytes)
+  : windowBytes(windowBytes), sievingPrimes(nullptr),
+    numSievingPrimes(0), numPresievedPrimes(0), numSmallSievingPrimes(0)
+{}
+
+template <typename primeType>
+void eratProducer<primeType>::start(const primeType* sievingPrimes,
+                                    const size_t numSievingPrimes)
+  noexcept(false)
+{
+  this->sievingPrimes = sievingPrimes;
+  this->numSievingPrimes = numSievingPrimes;
+
+  // The smallest primes are copied into every window along with the
+  // presieve pattern. A prime whose stride is larger than a window
+  // rarely hits it, so it is left to the buckets. They may hold
+  // primes of the previous slab, which are no longer guaranteed to
+  // be around.
+  const primeType* const end = sievingPrimes + numSievingPrimes;
+  numPresievedPrimes = upper_bound(
+    sievingPrimes, end,
+    static_cast<primeType>(DS::wheelSegment::kpresievePrimes[
+      DS::wheelSegment::knumPresievePrimes - 1])) - sievingPrimes;
+  numSmallSievingPrimes = max<size_t>(
+    upper_bound(sievingPrimes, end,
+                static_cast<primeType>(windowBytes)) - sievingPrimes,
+    numPresievedPrimes);
+  buckets.stopRun();
+}
+
+template <typename primeType>
+void eratProducer<primeType>::produce(DS::wheelSegment& segment,
+                                      const primeType leftLim,
+                                      const primeType rightLim)
+  noexcept(false)
+{
+  // Go through the window, each sieving prime at a time, marking
+  // their multiples as non-prime.
+  //
+  // The primes of the wheel never have to be marked, since their
+  // multiples are not even stored in the segment, and the next few
+  // come already marked by the presieve pattern.
+  segment.presieve(leftLim);
+  markSmallPrimes(segment, leftLim, rightLim);
+
+  // The windows a thread gets are mostly consecutive. Otherwise,
+  // the buckets are filled again from here.
+  if (numSmallSievingPrimes < numSievingPrimes) {
+    if (!buckets.continuesRun(leftLim)) {
+      buckets.startRun(sievingPrimes + numSmallSievingPrimes,
+                       numSievingPrimes - numSmallSievingPrimes,
+                       leftLim, segment.span());
+    }
+    buckets.markSegment(segment);
+  }
+}
+
+template <typename primeType>
+void eratProducer<primeType>::markSmallPrimes(DS::wheelSegment& segment,
+                                              const primeType leftLim,
+                                              const primeType rightLim)
+  const
+{
+  for (size_t i = numPresievedPrimes; i < numSmallSievingPrimes; ++i) {
+    const primeType curPrime = sievingPrimes[i];
+    if (curPrime * curPrime >= rightLim) {
+      // Everything unmarked is a prime!
+      break;
+    }
+    segment.markMultiples(curPrime, leftLim);
+  }
+}
+
+template class eratProducer<primeT>;
+
+}
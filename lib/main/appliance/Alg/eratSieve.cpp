@@ -6,55 +6,62 @@
 //===----------------------------------------------------------===//
 
 #include "Alg/eratSieve.hpp"
+#include "Alg/sieveEngine.hpp"
+#include "DS/pageArena.hpp"
 #include "Utils/error.hpp"
+#include "Utils/mpiType.hpp"
 #include "Utils/num.hpp"
+#include "Utils/profiler.hpp"
 
-#include <cmath>
+#include <algorithm>
 #include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include "mpi.h"
 
-#define PRINT_PRIMES {                                      \
-  if(ALG_ERATSIEVE_DEBUG) {                                 \
-    for (auto prime : *curPrimes) std::cout << prime << ' ';  \
-  }                                                           \
-  }
-
 using namespace std;
 using namespace Utils;
 
 namespace Alg {
 
-eratSieve::eratSieve(const cacheInfo* cinfo, 
-                     const unsigned userRightLim,
-                     vector<primeT>* curPrimes)
-  : cinfo(cinfo), userRightLim(userRightLim),
-    markWindow(num<unsigned>::min(userRightLim + 1, 
-                                  cinfo->size * 4)), // cache / 2
-    curPrimes(curPrimes),
-    numMarkedElems(0), windowLeftLim(0), markedElemsLeftLim(3),
-    numPrimesInFirstWindow(0)
+template <typename primeType>
+eratSieve<primeType>::eratSieve(const cacheInfo* cinfo, 
+                                const sieveConfig* config,
+                                const primeType userLeftLim,
+                                const primeType userRightLim,
+                                primeSink<primeType>* sink,
+                                uint64_t* numPrimes)
+  : cinfo(cinfo), config(config), userLeftLim(userLeftLim),
+    userRightLim(userRightLim),
+    maxSievingPrime(num<primeType>::isqrt(userRightLim)),
+    pool(config->numThreads),
+    tuplets(getTupletForms(config->tuplets)), findingTuplets(false),
+    sink(config->countOnly ? nullptr : sink),
+    pipelining(false), curParity(0),
+    numPrimes(numPrimes), numPrimesFound(0),
+    sievingPrimes(config->comm, maxSievingPrime), roundLeftLim(0),
+    roundRightLim(0)
 {
   try {
     LOG(ALG_ERATSIEVE_DEBUG, "(eratSieve) Start Constructor");
     initMPIVariables();
+    initBuffers();
+    if (!config->rankLocalOutput && myProcRank != 0) {
+      this->sink = nullptr;
+    }
 
-    initCurPrimes();
-    // We trust that userRightLim >= 2, which is controlled by the
-    // calling procedure.
-    markWindow[0] = 1;
-    markWindow[1] = 1;
-    markWindow[2] = 1;
-    numMarkedElems = 3;
-
-    firstPass(); // Get a lot of primes. This makes the process 
-                 //   much quicker.
+    // We trust that userLeftLim <= userRightLim, which is controlled
+    // by the calling procedure.
+    //
+    // Only the primes up to the square root of userRightLim are
+    // needed to sieve [userLeftLim, userRightLim]. Nothing between
+    // them and userLeftLim is ever sieved.
+    findSievingPrimes();
 
+    markPrimesLocal();
 
-    // If the user right lim is lesser, we don't even need to call
-    // the following procedure.
-    if (userRightLim > windowLeftLim) {
-      markPrimesLocal();
-    }
+    countPrimesGlobal();
   }
   catch (std::exception& e) {
     destroy();
@@ -64,189 +71,1019 @@ eratSieve::eratSieve(const cacheInfo* cinfo,
   LOG(ALG_ERATSIEVE_DEBUG, "(eratSieve) End Constructor");
 }
 
-eratSieve::~eratSieve()
+template <typename primeType>
+eratSieve<primeType>::~eratSieve()
 {
   destroy();
 }
 
 
-void eratSieve::initMPIVariables()
+template <typename primeType>
+void eratSieve<primeType>::initMPIVariables()
 {
-  MPI_Comm_rank(MPI_COMM_WORLD, &myProcRank);
-  MPI_Comm_size(MPI_COMM_WORLD, &commSz);
-  
-  // cinfo->size is in bytes.
-  interProcBusWidth = cinfo->size / (1.2 * sizeof(primeT));
+  MPI_Comm_rank(config->comm, &myProcRank);
+  MPI_Comm_size(config->comm, &commSz);
+  fuseSizes.resize(commSz);
+  fuseCounts.resize(commSz);
+  fuseDispls.resize(commSz);
 }
 
-void eratSieve::initCurPrimes()
+template <typename primeType>
+void eratSieve<primeType>::initBuffers()
 {
-  // Allocate a good amount of memory for the vector
-  unsigned numPrimesEstimate = userRightLim / log(userRightLim);
-  curPrimes->reserve(num<primeT>::max(numPrimesEstimate,
-                                     0xFFFFFF));
+  // The windows, and the lists of primes of the segments, are all
+  // the memory the threads of the pool write to. They are sized
+  // here, once and for all.
+  const size_t windowBytes = num<primeType>::min(
+    userRightLim / DS::wheelSegment::kwheelSz + 1, getWindowBytes());
+  const typename sieveEngine<primeType>::entry& engine =
+    config->engine.empty() ?
+    sieveEngine<primeType>::pick(userLeftLim, userRightLim) :
+    sieveEngine<primeType>::find(config->engine);
+  windows.reserve(pool.size());
+  for (unsigned i = 0; i < pool.size(); ++i) {
+    windows.emplace_back(windowBytes, engine.create(windowBytes));
+  }
 
-  curPrimes->push_back(2); // Start with 2 as the only prime
+  segPrimes.resize(
+    static_cast<size_t>(kbatchSegmentsPerThread) * pool.size());
+  segNumPrimes.resize(segPrimes.size());
+  segBorders.resize(segPrimes.size());
+  const uint64_t maxSegPrimes = DS::primeBounds::maxPrimesInSpan(
+    windows[0].markWindow.span());
+  for (vector<primeType>& primes : segPrimes) {
+    DS::pageArena::reserveHuge(primes, maxSegPrimes);
+  }
 }
 
-void eratSieve::destroy()
+template <typename primeType>
+vector<vector<unsigned>> eratSieve<primeType>::getTupletForms(
+  const tupletKind kind)
+{
+  switch (kind) {
+    case tupletKind::none:
+      break;
+    case tupletKind::twins:
+      return {{0, 2}};
+    case tupletKind::cousins:
+      return {{0, 4}};
+    case tupletKind::triplets:
+      return {{0, 2, 6}, {0, 4, 6}};
+    case tupletKind::quadruplets:
+      return {{0, 2, 6, 8}};
+  }
+  return {};
+}
+
+template <typename primeType>
+void eratSieve<primeType>::destroy()
 {
   // Put here the destructor's implementation
-//  PRINT_PRIMES
 }
 
 
-void eratSieve::firstPass()
+template <typename primeType>
+void eratSieve<primeType>::findSievingPrimes()
+{
+  PROFILE_SCOPE(profiler::kfindSievingPrimes);
+  firstPass(); // Get a lot of primes. This makes the process 
+               //   much quicker.
+
+  // Each round looks for sieving primes up to the square of its
+  // left limit. Then, the ones found by each process are shared, so
+  // that the next round can go further.
+  //
+  // A slab never spans more than its share of the sieving primes.
+  vector<primeType> mySievingPrimes;
+  DS::pageArena::reserveHuge(
+    mySievingPrimes, DS::primeBounds::maxPrimesInSpan(
+      (maxSievingPrime + commSz) / commSz + DS::wheelSegment::kwheelSz));
+  while (roundLeftLim <= maxSievingPrime) {
+    roundRightLim = getSievingRoundRightLim();
+
+    mySievingPrimes.clear();
+    sieveSlab(getLLimit(), getRLimit(), getRLimit(), &mySievingPrimes);
+    shareSievingPrimes(mySievingPrimes);
+
+    roundLeftLim = roundRightLim;
+  }
+}
+
+template <typename primeType>
+void eratSieve<primeType>::firstPass()
 {
-  // Do a first pass in all processes asynchronously. In terms of
-  //   execution time, this should be much faster.
+  PROFILE_SCOPE(profiler::kfirstPass);
+  // Do a first pass over a single window, in the leader of each
+  // host, without talking to anyone. The rest of the host reads its
+  // primes.
   //
-  // The point is that this gives us a good prime number to start
-  // with, fetched by getMaxPrimeLocal()
-  findPrimesBetween(3, markWindow.size());
-  numPrimesInFirstWindow = curPrimes->size();
+  // The point is that this gives us every sieving prime lesser than
+  // the size of the window to start with.
+  threadWindow& window = windows[0];
+
+  // Hosts may use windows of different sizes, but the rounds have to
+  // start at the same place everywhere. The primes past the smallest
+  // window are found again in the first round.
+  const primeType mySpan = window.markWindow.span();
+  MPI_Allreduce(&mySpan, &roundLeftLim, 1, mpiType<primeType>::get(),
+                MPI_MIN, config->comm);
+
+  vector<primeType> firstPrimes;
+  if (sievingPrimes.isWriter()) {
+    const primeType rightLim = num<primeType>::min(
+      roundLeftLim, maxSievingPrime + 1);
+
+    // If we went over all the primes, and there are numbers that
+    // were not marked, the first one of these is a prime. Its
+    // multiples are marked right away, and we continue our search.
+    window.windowLeftLim = 0;
+    window.markedElemsLeftLim = 7;
+    for (window.moveLeftMarkToRight();
+         window.markedElemsLeftLim * window.markedElemsLeftLim
+           < rightLim;
+         window.moveLeftMarkToRight()) {
+      firstPrimes.push_back(window.markedElemsLeftLim);
+      window.markWindow.markMultiples(window.markedElemsLeftLim, 0);
+      ++window.markedElemsLeftLim;
+    }
+    window.allUnmarkedArePrimes(rightLim, &firstPrimes);
+    window.resetMarkWindow();
+  }
+  sievingPrimes.assign(firstPrimes);
+}
+
+template <typename primeType>
+void eratSieve<primeType>::addSmallPrimes()
+{
+  // Every process knows the primes up to maxSievingPrime, but only
+  // the root reports the ones in the user range.
+  if (myProcRank != 0) {
+    return;
+  }
+  if (findingTuplets) {
+    addSmallTuplets();
+    return;
+  }
+
+  vector<primeType> smallPrimes;
+  const auto addIfInRange = [&](const primeType prime) {
+    if (prime >= userLeftLim && prime <= userRightLim) {
+      smallPrimes.push_back(prime);
+    }
+  };
+
+  for (const primeType wheelPrime : {2, 3, 5}) {
+    addIfInRange(wheelPrime);
+  }
+  for (const primeType sievingPrime : sievingPrimes) {
+    addIfInRange(sievingPrime);
+  }
+
+  numPrimesFound += smallPrimes.size();
+  if (sink) {
+    sink->consume(smallPrimes);
+  }
+}
+
+template <typename primeType>
+void eratSieve<primeType>::addSmallTuplets()
+{
+  // Tuplets that start below roundLeftLim start at a wheel prime or
+  // at a sieving prime, but may end past maxSievingPrime.
+  vector<primeType> smallTuplets;
+  const vector<vector<unsigned>> forms =
+    getTupletForms(config->tuplets);
+  const auto addIfTuplet = [&](const primeType first) {
+    if (first < userLeftLim || first >= roundLeftLim) {
+      return;
+    }
+    for (const vector<unsigned>& form : forms) {
+      bool isTuplet = first <= userRightLim &&
+        userRightLim - first >= form.back();
+      for (size_t i = 1; i < form.size() && isTuplet; ++i) {
+        isTuplet = isSmallPrime(first + form[i]);
+      }
+      if (isTuplet) {
+        smallTuplets.push_back(first);
+        return;
+      }
+    }
+  };
+
+  for (const primeType wheelPrime : {2, 3, 5}) {
+    addIfTuplet(wheelPrime);
+  }
+  for (const primeType sievingPrime : sievingPrimes) {
+    addIfTuplet(sievingPrime);
+  }
+
+  numPrimesFound += smallTuplets.size();
+  if (sink) {
+    sink->consume(smallTuplets);
+  }
 }
 
-void eratSieve::markPrimesLocal()
+template <typename primeType>
+bool eratSieve<primeType>::isSmallPrime(const primeType n) const
 {
+  if (n == 2 || n == 3 || n == 5) {
+    return true;
+  }
+  if (n < 7 || n % 2 == 0 || n % 3 == 0 || n % 5 == 0) {
+    return false;
+  }
+  if (n <= maxSievingPrime) {
+    return binary_search(sievingPrimes.begin(), sievingPrimes.end(),
+                         n);
+  }
+
+  // Every prime up to the square root of userRightLim is a sieving
+  // prime.
+  for (const primeType prime : sievingPrimes) {
+    if (prime * prime > n) {
+      break;
+    }
+    if (n % prime == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename primeType>
+void eratSieve<primeType>::markPrimesLocal()
+{
+  PROFILE_SCOPE(profiler::kmarkPrimesLocal);
   LOG(ALG_ERATSIEVE_DEBUG, "P%d In markPrimesLocal", myProcRank);
-  LOG(ALG_ERATSIEVE_DEBUG, "P%d windowLeftLim: %d", myProcRank, 
-      windowLeftLim);
-  // Calculate the left limit for the process
-  unsigned myLLimit = getLLimit();
-  unsigned myRLimit = getRLimit();
+  findingTuplets = !tuplets.empty();
+
+  // Whatever is lesser than 7 or not greater than maxSievingPrime
+  // is taken care of by addSmallPrimes.
+  roundLeftLim = num<primeType>::max(
+    userLeftLim, num<primeType>::max(maxSievingPrime + 1, 7));
+
+  // Every sieving prime is known at this point, so the whole range
+  // can be done in a single round, unless the primes have to be
+  // gathered in order into the root. Then, rounds are kept small, so
+  // that the root can hand a round over to the sink while the next
+  // one is sieved.
+  //
+  // A guided schedule takes the place of both, unless there is no
+  // one to share the work with.
+  if (config->schedule == scheduleMode::guided && commSz > 1 &&
+      !config->rankLocalOutput) {
+    if (sink) {
+      sink->start(userLeftLim, userRightLim);
+    }
+    addSmallPrimes();
+    if (roundLeftLim <= userRightLim) {
+      sieveGuided();
+    }
+    if (sink) {
+      PROFILE_SCOPE(profiler::koutput);
+      sink->finish();
+    }
+  }
+  else if (config->countOnly || config->rankLocalOutput) {
+    primeType myLLimit = userRightLim + 1;
+    primeType myRLimit = userRightLim + 1;
+    if (roundLeftLim <= userRightLim) {
+      roundRightLim = userRightLim + 1;
+      myLLimit = getLLimit();
+      myRLimit = getRLimit();
+    }
 
-  LOG(ALG_ERATSIEVE_DEBUG, "P%d myLLlimit, myRLimit: %u, %u", 
-      myProcRank, myLLimit, myRLimit);
+    LOG(ALG_ERATSIEVE_DEBUG, "P%d myLLlimit, myRLimit: %llu, %llu",
+        myProcRank, static_cast<unsigned long long>(myLLimit),
+        static_cast<unsigned long long>(myRLimit));
+
+    if (sink) {
+      // The small primes belong to the root, since they come first.
+      sink->start(myProcRank == 0 ? userLeftLim : myLLimit,
+                  myRLimit - 1);
+    }
+    addSmallPrimes();
+    if (sink) {
+      streamSlab(myLLimit, myRLimit);
+      PROFILE_SCOPE(profiler::koutput);
+      sink->finish();
+    }
+    else {
+      numPrimesFound += sieveSlab(myLLimit, myRLimit, myLLimit, nullptr);
+    }
+  }
+  else if (config->gather == gatherMode::pipelined && commSz > 1) {
+    if (sink) {
+      sink->start(userLeftLim, userRightLim);
+    }
+    addSmallPrimes();
+    sievePipelined();
+    if (sink) {
+      PROFILE_SCOPE(profiler::koutput);
+      sink->finish();
+    }
+  }
+  else {
+    if (sink) {
+      sink->start(userLeftLim, userRightLim);
+    }
+    addSmallPrimes();
 
+    // The gather of a round is completed after the next round is
+    // sieved, so each round goes to the buffer the round before the
+    // last one used. The root gets the primes of a whole round in
+    // its buffer, and the others those of their slab.
+    const size_t maxRoundPrimes = getMaxRoundPrimes(
+      myProcRank == 0 ? commSz * kstreamSlabSpan :
+      kstreamSlabSpan + DS::wheelSegment::kwheelSz);
+    for (vector<primeType>& primes : roundPrimes) {
+      DS::pageArena::reserveHuge(primes, maxRoundPrimes);
+    }
+    unsigned round = 0;
+    for (; roundLeftLim <= userRightLim; ++round) {
+      roundRightLim = roundLeftLim + num<primeType>::min(
+        userRightLim - roundLeftLim + 1, commSz * kstreamSlabSpan);
 
+      LOG(ALG_ERATSIEVE_DEBUG, "P%d roundLeftLim: %llu", myProcRank,
+          static_cast<unsigned long long>(roundLeftLim));
 
-  windowLeftLim = markedElemsLeftLim = myLLimit;
- 
-  findPrimesBetween(myLLimit, myRLimit);
+      vector<primeType>& primes = roundPrimes[round % 2];
+      primes.clear();
+      numPrimesFound +=
+        sieveSlab(getLLimit(), getRLimit(), getRLimit(), &primes);
+      if (round > 0) {
+        waitCurPrimesFused(roundPrimes[(round + 1) % 2]);
+      }
+      fuseCurPrimesGlobal(primes);
 
-  // Fixme: add loop with fusing, to support numbers greater than
-  // the size of the window squared.
-  fuseCurPrimesGlobal(myLLimit, myRLimit);
+      roundLeftLim = roundRightLim;
+    }
+    if (round > 0) {
+      waitCurPrimesFused(roundPrimes[(round + 1) % 2]);
+    }
+    if (sink) {
+      PROFILE_SCOPE(profiler::koutput);
+      sink->finish();
+    }
+  }
 
   LOG(ALG_ERATSIEVE_DEBUG, "P%d Out markPrimesLocal", myProcRank);
 }
 
-
-void eratSieve::findPrimesBetween(const unsigned leftLim,
-                                  const unsigned rightLim)
+template <typename primeType>
+void eratSieve<primeType>::sievePipelined()
 {
-  // Go through the bitset, each prime at a time, marking their
-  // multiples as non-prime.
+  // Rounds are split evenly, as with the plain gather, but a process
+  // does not wait for the end of its slab to send its primes. Each
+  // batch of segments goes out as soon as it is sieved, straight
+  // from the round buffer, which never moves since it has room for
+  // the whole slab. An empty batch closes the slab.
   //
-  // End when the counter equals the size of the vector, or we have
-  // gone through all the primes we have.
+  // The root takes the batches in between its own, into a buffer
+  // per process, and hands the previous round to the sink once it
+  // has sieved its slab of the current one.
+  const primeType maxSlabSpan =
+    kstreamSlabSpan + DS::wheelSegment::kwheelSz;
+  const size_t maxSlabPrimes = getMaxRoundPrimes(maxSlabSpan);
+  const primeType segSpan = windows[0].markWindow.span();
+  const size_t maxSlabBatches =
+    (maxSlabSpan / segSpan + 2) / segPrimes.size() + 1;
+  for (unsigned parity = 0; parity < 2; ++parity) {
+    DS::pageArena::reserveHuge(roundPrimes[parity], maxSlabPrimes);
+    if (myProcRank == 0) {
+      rankPrimes[parity].resize(commSz);
+      for (int rank = 1; rank < commSz; ++rank) {
+        DS::pageArena::reserveHuge(rankPrimes[parity][rank],
+                                   maxSlabPrimes);
+      }
+      rankRecvs[parity].assign(commSz, MPI_REQUEST_NULL);
+      rankDone[parity].assign(commSz, true);
+    }
+    else {
+      batchSends[parity].reserve(maxSlabBatches + 1);
+    }
+  }
 
-  // Walk by blocks of size of markWindow->size().
-  // Notice that windowLeftLim != markedElemsLeftLim
-  for (markedElemsLeftLim = leftLim;
-       markedElemsLeftLim < rightLim;
-       windowLeftLim += markWindow.size(),
-         markedElemsLeftLim = windowLeftLim) {
-
-    primeT curPrime = 0;
-    for (auto lit = curPrimes->begin(); 
-         numMarkedElems < markWindow.size()
-           && markedElemsLeftLim < rightLim;
-         lit++) {
-
-      if ((*lit) * (*lit) > windowLeftLim + markWindow.size()) {
-        // Everything unmarked is a prime!        
-        break;
+  unsigned round = 0;
+  for (; roundLeftLim <= userRightLim; ++round) {
+    roundRightLim = roundLeftLim + num<primeType>::min(
+      userRightLim - roundLeftLim + 1, commSz * kstreamSlabSpan);
+    curParity = round % 2;
+
+    // The round before the last one is out, so its buffers are free.
+    vector<primeType>& primes = roundPrimes[curParity];
+    if (myProcRank == 0) {
+      fill(rankDone[curParity].begin() + 1, rankDone[curParity].end(),
+           false);
+    }
+    else {
+      PROFILE_SCOPE(profiler::kfuseCurPrimesGlobal);
+      MPI_Waitall(batchSends[curParity].size(),
+                  batchSends[curParity].data(), MPI_STATUSES_IGNORE);
+      batchSends[curParity].clear();
+    }
+    primes.clear();
+
+    pipelining = true;
+    numPrimesFound +=
+      sieveSlab(getLLimit(), getRLimit(), getRLimit(), &primes);
+    pipelining = false;
+
+    if (myProcRank != 0) {
+      sendBatch(nullptr, 0);
+    }
+    else if (round > 0) {
+      emitPipelinedRound(1 - curParity);
+    }
+
+    roundLeftLim = roundRightLim;
+  }
+
+  if (myProcRank == 0) {
+    if (round > 0) {
+      emitPipelinedRound((round - 1) % 2);
+    }
+  }
+  else {
+    PROFILE_SCOPE(profiler::kfuseCurPrimesGlobal);
+    for (vector<MPI_Request>& sends : batchSends) {
+      MPI_Waitall(sends.size(), sends.data(), MPI_STATUSES_IGNORE);
+      sends.clear();
+    }
+  }
+}
+
+template <typename primeType>
+void eratSieve<primeType>::pipelineBatch(const primeType* batch,
+                                         const size_t num)
+{
+  // The root keeps the receives of both rounds going.
+  if (myProcRank == 0) {
+    receiveBatches(0, false);
+    receiveBatches(1, false);
+  }
+  else if (num > 0) {
+    sendBatch(batch, num);
+  }
+}
+
+template <typename primeType>
+void eratSieve<primeType>::sendBatch(const primeType* batch,
+                                     const size_t num)
+{
+  PROFILE_SCOPE(profiler::kfuseCurPrimesGlobal);
+  batchSends[curParity].push_back(MPI_REQUEST_NULL);
+  MPI_Isend(batch, num, mpiType<primeType>::get(), 0,
+            kbatchTag + curParity, config->comm,
+            &batchSends[curParity].back());
+}
+
+template <typename primeType>
+void eratSieve<primeType>::receiveBatches(const unsigned parity,
+                                          const bool wait)
+{
+  PROFILE_SCOPE(profiler::kfuseCurPrimesGlobal);
+  // Each process has a receive in flight at most. Its next batch is
+  // only looked for once the one before is in, and goes right after
+  // it.
+  for (;;) {
+    bool allDone = true;
+    for (int rank = 1; rank < commSz; ++rank) {
+      if (rankDone[parity][rank]) {
+        continue;
+      }
+      allDone = false;
+
+      MPI_Request& request = rankRecvs[parity][rank];
+      if (request != MPI_REQUEST_NULL) {
+        int received;
+        MPI_Test(&request, &received, MPI_STATUS_IGNORE);
+        if (!received) {
+          continue;
+        }
       }
 
-      // If we went over all the primes, and there are numbers that
-      // were not marked, the first one of these is a prime, and we
-      // should continue our search
-      moveLeftMarkToRight();
-      curPrimes->push_back(markedElemsLeftLim);
-      markPrimeAt(markedElemsLeftLim % markWindow.size());
-
-      // Choose the prime, and then walk the vector marking its
-      // multiples as non-primes
-      
-      curPrime = *lit;
-
-      // Example:
-      // curPrime = 3931
-      // windowLeftLimit = 12000
-      // markWindow.size() = 4000
-      // (12000 + 3931 - 69) % 4000 = (2 * 3931) % 4000 = 3862     
-      //
-      // Current prime multiple
-      primeT curPrimeMul = (curPrime - (windowLeftLim % curPrime))
-        % markWindow.size();
-      for (;
-           curPrimeMul < markWindow.size();
-           curPrimeMul += curPrime) {
-        markPrimeAt(curPrimeMul);
+      int arrived;
+      MPI_Message message;
+      MPI_Status status;
+      MPI_Improbe(rank, kbatchTag + parity, config->comm, &arrived,
+                  &message, &status);
+      if (!arrived) {
+        continue;
       }
+      int numPrimes;
+      MPI_Get_count(&status, mpiType<primeType>::get(), &numPrimes);
+      if (numPrimes == 0) {
+        MPI_Mrecv(nullptr, 0, mpiType<primeType>::get(), &message,
+                  MPI_STATUS_IGNORE);
+        rankDone[parity][rank] = true;
+        continue;
+      }
+      vector<primeType>& primes = rankPrimes[parity][rank];
+      const size_t offset = primes.size();
+      primes.resize(offset + numPrimes);
+      MPI_Imrecv(primes.data() + offset, numPrimes,
+                 mpiType<primeType>::get(), &message, &request);
+    }
+
+    if (allDone || !wait) {
+      return;
     }
-    allUnmarkedArePrimes(rightLim);
   }
+}
+
+template <typename primeType>
+void eratSieve<primeType>::emitPipelinedRound(const unsigned parity)
+{
+  receiveBatches(parity, true);
+
+  PROFILE_SCOPE(profiler::koutput);
+  if (sink) {
+    sink->consume(roundPrimes[parity]);
+  }
+  roundPrimes[parity].clear();
+  for (int rank = 1; rank < commSz; ++rank) {
+    if (sink) {
+      sink->consume(rankPrimes[parity][rank]);
+    }
+    rankPrimes[parity][rank].clear();
+  }
+}
+
+template <typename primeType>
+void eratSieve<primeType>::streamSlab(const primeType myLeftLim,
+                                      const primeType myRightLim)
+{
+  // The slab goes to the sink piece by piece, so that no more than a
+  // piece is ever held.
+  vector<primeType>& primes = roundPrimes[0];
+  DS::pageArena::reserveHuge(primes, getMaxRoundPrimes(kstreamSlabSpan));
+  for (primeType leftLim = myLeftLim; leftLim < myRightLim;) {
+    const primeType rightLim = leftLim +
+      num<primeType>::min(myRightLim - leftLim, kstreamSlabSpan);
+    primes.clear();
+    numPrimesFound += sieveSlab(leftLim, rightLim, rightLim, &primes);
+    PROFILE_SCOPE(profiler::koutput);
+    sink->consume(primes);
+    leftLim = rightLim;
+  }
+}
 
+template <typename primeType>
+vector<primeType> eratSieve<primeType>::getGuidedChunks() const
+{
+  // Limits of the chunks of [roundLeftLim, userRightLim], the i-th
+  // one being [chunkLims[i], chunkLims[i + 1]). Every process works
+  // out the same ones. When listing, a chunk is also held whole by
+  // the process that sieves it, so it is kept to a slab of
+  // streamSlab.
+  vector<primeType> chunkLims{roundLeftLim};
+  const primeType rightLim = userRightLim + 1;
+  for (primeType leftLim = roundLeftLim; leftLim < rightLim;) {
+    primeType chunkSz = num<primeType>::max(
+      (rightLim - leftLim) / (kguidedDivisor * commSz),
+      kminGuidedChunk);
+    if (!config->countOnly) {
+      chunkSz = num<primeType>::min(chunkSz, kstreamSlabSpan);
+    }
+    leftLim = rightLim - leftLim <= chunkSz ? rightLim :
+      leftLim + chunkSz - (leftLim + chunkSz) % DS::wheelSegment::kwheelSz;
+    chunkLims.push_back(leftLim);
+  }
+  return chunkLims;
 }
 
-void eratSieve::fuseCurPrimesGlobal(const unsigned myLeftLim,
-                                    const unsigned myRightLim)
+template <typename primeType>
+void eratSieve<primeType>::sieveGuided()
 {
+  const vector<primeType> chunkLims = getGuidedChunks();
+  const uint64_t numChunks = chunkLims.size() - 1;
+  const bool listing = !config->countOnly;
+
+  // The index of the next chunk to claim lives in the root.
+  uint64_t* counter;
+  MPI_Win counterWin;
+  MPI_Win_allocate(myProcRank == 0 ? sizeof(uint64_t) : 0,
+                   sizeof(uint64_t), MPI_INFO_NULL, config->comm,
+                   &counter, &counterWin);
   if (myProcRank == 0) {
-    // How many primes should I receive?
-    // Create vector with sizes of receives
-    unsigned numReceives = (commSz - 1);
-
-    MPI_Status status;    
-    // Receive prime arrays
-    primeT* primeArr = new primeT [interProcBusWidth];
-    for (unsigned i = 0; i < numReceives; ++i) {
-      
-      unsigned recvSz;
-      MPI_Recv(&recvSz, 1, MPI::UNSIGNED, i + 1, 0, MPI_COMM_WORLD,
-               &status);
-
-      int numPrimesNotRcvd = recvSz;
-      for (; numPrimesNotRcvd > 0; 
-           numPrimesNotRcvd -= interProcBusWidth) {
-        MPI_Recv(primeArr, 
-                 num<unsigned>::min(recvSz, interProcBusWidth),
-                 MPI::UNSIGNED, i + 1, 0, MPI_COMM_WORLD, &status);
-
-        // FIXME: this copying process can be made quite more
-        // efficient
-        for (unsigned ii = 0; 
-             ii < num<primeT>::min(status._ucount / sizeof(primeT), 
-                                          numPrimesNotRcvd);
-             ++ii) {
-          curPrimes->push_back(primeArr[ii]);
+    *counter = 0;
+  }
+  MPI_Barrier(config->comm);
+  MPI_Win_lock_all(0, counterWin);
+
+  // Chunks of the root, and the ones received, waiting for their
+  // turn. Each of the other processes sends a chunk while sieving
+  // the next one, out of roundPrimes.
+  if (listing && myProcRank != 0) {
+    for (vector<primeType>& primes : roundPrimes) {
+      DS::pageArena::reserveHuge(primes,
+                                 getMaxRoundPrimes(kstreamSlabSpan));
+    }
+  }
+  map<uint64_t, vector<primeType>> pending;
+  uint64_t nextChunk = 0;
+  uint64_t chunkIdxs[2];
+  MPI_Request sendRequests[2][2] = {
+    {MPI_REQUEST_NULL, MPI_REQUEST_NULL},
+    {MPI_REQUEST_NULL, MPI_REQUEST_NULL}};
+  unsigned numSieved = 0;
+
+  for (;;) {
+    const uint64_t one = 1;
+    uint64_t chunk;
+    MPI_Fetch_and_op(&one, &chunk, MPI_UINT64_T, 0, 0, MPI_SUM,
+                     counterWin);
+    MPI_Win_flush(0, counterWin);
+    if (chunk >= numChunks) {
+      break;
+    }
+
+    const primeType leftLim = chunkLims[chunk];
+    const primeType rightLim = chunkLims[chunk + 1];
+    if (!listing) {
+      numPrimesFound += sieveSlab(leftLim, rightLim, leftLim, nullptr);
+      continue;
+    }
+
+    if (myProcRank == 0) {
+      vector<primeType>& primes = pending[chunk];
+      takeChunkBuffer(primes);
+      numPrimesFound += sieveSlab(leftLim, rightLim, rightLim, &primes);
+      receiveChunks(pending, &nextChunk, false);
+      continue;
+    }
+
+    const unsigned buf = numSieved++ % 2;
+    vector<primeType>& primes = roundPrimes[buf];
+    MPI_Waitall(2, sendRequests[buf], MPI_STATUSES_IGNORE);
+    primes.clear();
+    numPrimesFound += sieveSlab(leftLim, rightLim, rightLim, &primes);
+
+    PROFILE_SCOPE(profiler::kfuseCurPrimesGlobal);
+    chunkIdxs[buf] = chunk;
+    MPI_Isend(&chunkIdxs[buf], 1, MPI_UINT64_T, 0, kchunkIdxTag,
+              config->comm, &sendRequests[buf][0]);
+    MPI_Isend(primes.data(), primes.size(), mpiType<primeType>::get(),
+              0, kchunkPrimesTag, config->comm, &sendRequests[buf][1]);
+  }
+
+  if (listing) {
+    if (myProcRank == 0) {
+      while (nextChunk < numChunks) {
+        receiveChunks(pending, &nextChunk, true);
+      }
+    }
+    else {
+      PROFILE_SCOPE(profiler::kfuseCurPrimesGlobal);
+      MPI_Waitall(4, &sendRequests[0][0], MPI_STATUSES_IGNORE);
+    }
+  }
+
+  MPI_Win_unlock_all(counterWin);
+  MPI_Win_free(&counterWin);
+}
+
+template <typename primeType>
+void eratSieve<primeType>::receiveChunks(
+  map<uint64_t, vector<primeType>>& pending, uint64_t* nextChunk,
+  const bool wait)
+{
+  {
+    PROFILE_SCOPE(profiler::kfuseCurPrimesGlobal);
+    for (bool first = true;; first = false) {
+      MPI_Status status;
+      int arrived = 0;
+      if (wait && first) {
+        MPI_Probe(MPI_ANY_SOURCE, kchunkIdxTag, config->comm, &status);
+        arrived = 1;
+      }
+      else {
+        MPI_Iprobe(MPI_ANY_SOURCE, kchunkIdxTag, config->comm, &arrived,
+                   &status);
+      }
+      if (!arrived) {
+        break;
+      }
+
+      // A process sends the primes of a chunk right after its index.
+      uint64_t chunk;
+      MPI_Recv(&chunk, 1, MPI_UINT64_T, status.MPI_SOURCE, kchunkIdxTag,
+               config->comm, MPI_STATUS_IGNORE);
+      MPI_Probe(status.MPI_SOURCE, kchunkPrimesTag, config->comm,
+                &status);
+      int numPrimes;
+      MPI_Get_count(&status, mpiType<primeType>::get(), &numPrimes);
+      vector<primeType>& primes = pending[chunk];
+      takeChunkBuffer(primes);
+      primes.resize(numPrimes);
+      MPI_Recv(primes.data(), numPrimes, mpiType<primeType>::get(),
+               status.MPI_SOURCE, kchunkPrimesTag, config->comm,
+               MPI_STATUS_IGNORE);
+    }
+  }
+
+  emitChunks(pending, nextChunk);
+}
+
+template <typename primeType>
+void eratSieve<primeType>::emitChunks(
+  map<uint64_t, vector<primeType>>& pending, uint64_t* nextChunk)
+{
+  PROFILE_SCOPE(profiler::koutput);
+  for (auto it = pending.begin();
+       it != pending.end() && it->first == *nextChunk;
+       it = pending.erase(it), ++*nextChunk) {
+    if (sink) {
+      sink->consume(it->second);
+    }
+    it->second.clear();
+    spareChunks.push_back(std::move(it->second));
+  }
+}
+
+template <typename primeType>
+void eratSieve<primeType>::takeChunkBuffer(vector<primeType>& primes)
+{
+  // A chunk is never larger than a slab of streamSlab.
+  if (spareChunks.empty()) {
+    DS::pageArena::reserveHuge(primes,
+                               getMaxRoundPrimes(kstreamSlabSpan));
+    return;
+  }
+  primes.swap(spareChunks.back());
+  spareChunks.pop_back();
+}
+
+template <typename primeType>
+uint64_t eratSieve<primeType>::sieveSlab(const primeType myLeftLim,
+                                         const primeType myRightLim,
+                                         const primeType listRightLim,
+                                         vector<primeType>* primes)
+{
+  if (myLeftLim >= myRightLim) {
+    return 0;
+  }
+
+  // The slab is cut into segments of the size of a window, which
+  // the threads of the pool sieve, each on its own window. The
+  // primes of every segment lesser than listRightLim are then
+  // appended to ~primes~ in order. The others are only counted.
+  // Returns how many primes were found in total.
+  //
+  // Looking for tuplets, a tuplet belongs to the slab that holds its
+  // first number, so the slab is sieved a little past its end, for
+  // the tuplets that start right before it. The ones that run from
+  // a segment into the next are put together as the segments are
+  // merged.
+  const primeType sieveRightLim = findingTuplets ?
+    num<primeType>::min(myRightLim + tuplets.span(),
+                        userRightLim + 1) :
+    myRightLim;
+  const primeType segSpan = windows[0].markWindow.span();
+  const primeType firstSegLeftLim =
+    myLeftLim - myLeftLim % DS::wheelSegment::kwheelSz;
+  const uint64_t numSegments =
+    (sieveRightLim - firstSegLeftLim + segSpan - 1) / segSpan;
+
+  // sievingPrimes may have grown since the last slab, and moved.
+  for (threadWindow& window : windows) {
+    window.producer->start(sievingPrimes.data(), sievingPrimes.size());
+  }
+
+  // Segments are handed out in batches, so that the primes of a
+  // batch can be merged before the next one starts.
+  const uint64_t batchSz = segPrimes.size();
+  uint64_t numFound = 0;
+  segBorder prevBorder{0, 0, 0, 0};
+
+  for (uint64_t firstSeg = 0; firstSeg < numSegments;
+       firstSeg += batchSz) {
+    const size_t numTasks =
+      num<uint64_t>::min(batchSz, numSegments - firstSeg);
+
+    pool.run(numTasks, [&](const unsigned threadIdx, const size_t i) {
+        const primeType segLeftLim =
+          firstSegLeftLim + (firstSeg + i) * segSpan;
+        segPrimes[i].clear();
+        if (findingTuplets) {
+          segNumPrimes[i] = findTupletsBetween(
+            windows[threadIdx],
+            num<primeType>::max(segLeftLim, myLeftLim),
+            num<primeType>::min(segLeftLim + segSpan, myRightLim),
+            num<primeType>::min(segLeftLim + segSpan, sieveRightLim),
+            primes ? &segPrimes[i] : nullptr, &segBorders[i]);
+          return;
         }
+        segNumPrimes[i] = findPrimesBetween(
+          windows[threadIdx],
+          num<primeType>::max(segLeftLim, myLeftLim),
+          num<primeType>::min(segLeftLim + segSpan, myRightLim),
+          listRightLim, &segPrimes[i]);
+      });
+
+    const size_t numBefore = primes ? primes->size() : 0;
+    for (size_t i = 0; i < numTasks; ++i) {
+      if (findingTuplets) {
+        numFound += joinSegments(prevBorder, segBorders[i], primes);
+        prevBorder = segBorders[i];
       }
+      if (primes) {
+        primes->insert(primes->end(), segPrimes[i].begin(),
+                       segPrimes[i].end());
+      }
+      numFound += segNumPrimes[i];
+    }
+    if (pipelining) {
+      pipelineBatch(primes->data() + numBefore,
+                    primes->size() - numBefore);
     }
+  }
+
+  return numFound;
+}
 
-    delete[] primeArr;
+template <typename primeType>
+uint64_t eratSieve<primeType>::findPrimesBetween(
+  threadWindow& window, const primeType leftLim,
+  const primeType rightLim, const primeType listRightLim,
+  vector<primeType>* primes) const
+{
+  // Each window is sieved by the producer of the thread, and then
+  // gone through for what is left unmarked.
+  //
+  // Primes lesser than listRightLim are added to ~primes~, and the
+  // others are only counted.
+  const DS::wheelSegment& markWindow = window.markWindow;
+  uint64_t numFound = 0;
+
+  // Walk by blocks of markWindow.span() numbers. Windows always
+  // start at a multiple of the wheel size.
+  // Notice that windowLeftLim != markedElemsLeftLim
+  for (window.windowLeftLim =
+         leftLim - leftLim % DS::wheelSegment::kwheelSz,
+         window.markedElemsLeftLim = leftLim;
+       window.windowLeftLim < rightLim;
+       window.windowLeftLim += markWindow.span(),
+         window.markedElemsLeftLim = window.windowLeftLim) {
+
+    window.producer->produce(
+      window.markWindow, window.windowLeftLim,
+      num<primeType>::min(window.windowLeftLim + markWindow.span(),
+                          rightLim));
+
+    numFound += window.allUnmarkedArePrimes(listRightLim, primes);
+    numFound += window.countUnmarked(rightLim);
   }
-  else {
-    unsigned size = curPrimes->size() - numPrimesInFirstWindow;
-    MPI_Send(&size, 1, MPI::UNSIGNED, 0, 0, MPI_COMM_WORLD);
 
-    int szDecounter = 0;
-    unsigned i = 0;
-    // Send information in blocks
-    for (szDecounter = size, i = 0; szDecounter > 0; 
-         szDecounter -= interProcBusWidth,
-         i += interProcBusWidth) {
-      MPI_Send(&(*curPrimes)[i + numPrimesInFirstWindow],
-               Utils::num<unsigned>::min(szDecounter, 
-                                         interProcBusWidth),
-               MPI::UNSIGNED, 0, 0, 
-               MPI_COMM_WORLD);
+  return numFound;
+}
+
+template <typename primeType>
+uint64_t eratSieve<primeType>::findTupletsBetween(
+  threadWindow& window, const primeType leftLim,
+  const primeType rightLim, const primeType sieveRightLim,
+  vector<primeType>* primes, segBorder* border) const
+{
+  // The tuplets have to start in [leftLim, rightLim), which may be
+  // empty, and end before sieveRightLim. The segment fits in a
+  // single window, since sieveSlab cuts the slab at multiples of
+  // the span of the windows.
+  const DS::wheelSegment& markWindow = window.markWindow;
+  window.windowLeftLim = leftLim - leftLim % DS::wheelSegment::kwheelSz;
+  window.producer->produce(window.markWindow, window.windowLeftLim,
+                           sieveRightLim);
+
+  const size_t firstBit = DS::wheelSegment::offsetToBit(
+    leftLim - window.windowLeftLim);
+  const size_t lastBit = DS::wheelSegment::offsetToBit(
+    num<primeType>::max(rightLim, leftLim) - window.windowLeftLim);
+  const size_t endBit = DS::wheelSegment::offsetToBit(
+    sieveRightLim - window.windowLeftLim);
+  const uint64_t numFound = markWindow.findTuplets(
+    tuplets, firstBit, lastBit, endBit, window.windowLeftLim, primes);
+
+  // Tuplets that start in the last byte may still end in the next
+  // window, if the slab goes on.
+  border->head = markWindow.getUnmarkedByte(0, endBit);
+  border->tailStarts = 0;
+  if (endBit == markWindow.numBits()) {
+    const size_t tailBit =
+      markWindow.numBits() - DS::wheelSegment::knumResidues;
+    const size_t firstTailBit = num<size_t>::max(firstBit, tailBit);
+    if (firstTailBit < lastBit) {
+      border->tail = markWindow.getUnmarkedByte(
+        markWindow.numBytes() - 1, endBit);
+      border->tailStarts = static_cast<uint8_t>(
+        ((1U << (lastBit - tailBit)) - 1) &
+        ~((1U << (firstTailBit - tailBit)) - 1));
+      border->tailLeftLim = window.windowLeftLim + markWindow.span()
+        - DS::wheelSegment::kwheelSz;
     }
   }
 
+  return numFound;
 }
 
+template <typename primeType>
+uint64_t eratSieve<primeType>::joinSegments(
+  const segBorder& prev, const segBorder& next,
+  vector<primeType>* primes) const
+{
+  if (prev.tailStarts == 0) {
+    return 0;
+  }
+
+  // The tuplets that only show up with the next byte there.
+  const uint64_t joined = prev.tail |
+    static_cast<uint64_t>(next.head) << DS::wheelSegment::knumResidues;
+  uint64_t starts = tuplets.findStarts(joined, 0) &
+    ~tuplets.findStarts(prev.tail, 0) & prev.tailStarts;
+
+  const uint64_t numFound = __builtin_popcountll(starts);
+  if (primes) {
+    for (; starts != 0; starts &= starts - 1) {
+      primes->push_back(prev.tailLeftLim +
+                        DS::wheelSegment::bitToOffset(
+                          __builtin_ctzll(starts)));
+    }
+  }
+  return numFound;
+}
+
+template <typename primeType>
+void eratSieve<primeType>::shareSievingPrimes(
+  const vector<primeType>& myPrimes)
+{
+  PROFILE_SCOPE(profiler::kshareSievingPrimes);
+  // The slabs are ordered by rank, so appending in the order of the
+  // ranks keeps sievingPrimes sorted.
+  sievingPrimes.appendAll(myPrimes);
+}
+
+template <typename primeType>
+void eratSieve<primeType>::fuseCurPrimesGlobal(vector<primeType>& primes)
+{
+  PROFILE_SCOPE(profiler::kfuseCurPrimesGlobal);
+  // Everyone learns how many primes each process found in the round,
+  // so that the root can make room for all of them at once.
+  const uint64_t mySz = primes.size();
+  MPI_Allgather(&mySz, 1, MPI_UINT64_T, fuseSizes.data(), 1,
+                MPI_UINT64_T, config->comm);
+
+  // MPI counts and displacements are ints.
+  uint64_t totalSz = 0;
+  for (int i = 0; i < commSz; ++i) {
+    totalSz += fuseSizes[i];
+    if (totalSz > static_cast<uint64_t>(numeric_limits<int>::max())) {
+      throw std::overflow_error{
+        "Too many primes in a single round to gather them: " +
+          to_string(totalSz)};
+    }
+    fuseCounts[i] = fuseSizes[i];
+    fuseDispls[i] = i > 0 ? fuseDispls[i - 1] + fuseCounts[i - 1] : 0;
+  }
+
+  // The primes of the root are already in place, right before the
+  // ones of the other processes.
+  if (myProcRank == 0) {
+    primes.resize(totalSz);
+    MPI_Igatherv(MPI_IN_PLACE, 0, mpiType<primeType>::get(),
+                 primes.data(), fuseCounts.data(), fuseDispls.data(),
+                 mpiType<primeType>::get(), 0, config->comm,
+                 &fuseRequest);
+  }
+  else {
+    MPI_Igatherv(primes.data(), fuseCounts[myProcRank],
+                 mpiType<primeType>::get(), nullptr, nullptr, nullptr,
+                 mpiType<primeType>::get(), 0, config->comm,
+                 &fuseRequest);
+  }
+}
+
+template <typename primeType>
+void eratSieve<primeType>::waitCurPrimesFused(vector<primeType>& primes)
+{
+  {
+    PROFILE_SCOPE(profiler::kfuseCurPrimesGlobal);
+    MPI_Wait(&fuseRequest, MPI_STATUS_IGNORE);
+  }
+
+  // The root process owns these primes now.
+  if (sink) {
+    PROFILE_SCOPE(profiler::koutput);
+    sink->consume(primes);
+  }
+  primes.clear();
+}
+
+template <typename primeType>
+void eratSieve<primeType>::countPrimesGlobal()
+{
+  MPI_Reduce(&numPrimesFound, numPrimes, 1, MPI_UINT64_T, MPI_SUM, 0,
+             config->comm);
+}
+
+template class eratSieve<primeT>;
+
 }
@@ -0,0 +1,411 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: implementation of class ~lmoCounter~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Alg/lmoCounter.hpp"
+
+#include "Alg/primeSink.hpp"
+#include "Alg/vectorSink.hpp"
+#include "DS/wheelSegment.hpp"
+#include "Utils/num.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+using namespace Utils;
+
+namespace Alg {
+
+namespace {
+
+// Sums pi(t), relative to the left limit of the numbers it is fed,
+// over a list of targets t given in increasing order.
+class piSink : public primeSink<primeT> {
+public:
+  // ~count~ primes come before the first one fed.
+  piSink(const vector<primeT>& targets, const uint64_t count)
+    : targets(targets), next(0), count(count), sum(0)
+  {}
+
+  void start(const primeT, const primeT) override
+  {}
+
+  void consume(vector<primeT>& primes) override
+  {
+    if (primes.empty()) {
+      return;
+    }
+
+    // Targets past the last prime of the chunk wait for the next
+    // one, which may still have primes up to them.
+    for (; next < targets.size() && targets[next] < primes.back();
+         ++next) {
+      sum += count +
+        (upper_bound(primes.begin(), primes.end(), targets[next])
+         - primes.begin());
+    }
+    count += primes.size();
+  }
+
+  void finish() override
+  {
+    for (; next < targets.size(); ++next) {
+      sum += count;
+    }
+  }
+
+  inline uint64_t getSum() const
+  {
+    return sum;
+  }
+
+private:
+  const vector<primeT>& targets;
+  size_t next;
+  uint64_t count;
+  uint64_t sum;
+};
+
+}
+
+lmoCounter::lmoCounter(const cacheInfo* cinfo,
+                       const sieveConfig* config, const primeT x,
+                       uint64_t* numPrimes) noexcept(false)
+  : cinfo(cinfo), config(config), x(x), y(getY(x)), z(x / y),
+    pool(config->numThreads)
+{
+  MPI_Comm_rank(config->comm, &myProcRank);
+  MPI_Comm_size(config->comm, &commSz);
+
+  *numPrimes = countAll();
+}
+
+bool lmoCounter::beatsSieve(const primeT leftLim,
+                            const primeT rightLim)
+{
+  // The leaves cost about x^(2/3) each time around, and we go
+  // around twice with a left limit.
+  if (rightLim < kminLimit || leftLim > rightLim) {
+    return false;
+  }
+  const primeT cbrtX = num<primeT>::icbrt(rightLim);
+  const long double lmoCost = (leftLim > 0 ? 2.0L : 1.0L)
+    * kcostRatio * cbrtX * cbrtX;
+  return lmoCost < static_cast<long double>(rightLim - leftLim);
+}
+
+uint64_t lmoCounter::countAll() noexcept(false)
+{
+  if (x < kminLimit) {
+    sieveConfig countConfig = *config;
+    countConfig.countOnly = true;
+    countConfig.rankLocalOutput = false;
+    uint64_t count = 0;
+    eratSieve<primeT>(cinfo, &countConfig, 0, x, nullptr, &count);
+    MPI_Bcast(&count, 1, MPI_UINT64_T, 0, config->comm);
+    return count;
+  }
+
+  buildTables();
+
+  uint64_t numP2Primes = 0;
+  const uint64_t p2Sum = computeP2(&numP2Primes);
+  uint64_t local[2] = {computeS1() + computeS2() - p2Sum,
+                       numP2Primes};
+  uint64_t total[2] = {0, 0};
+  MPI_Reduce(local, total, 2, MPI_UINT64_T, MPI_SUM, 0, config->comm);
+
+  // P2 = sum of pi(x / p) - (pi(p) - 1) over the primes p in
+  // (y, sqrt(x)], whose pi go from a + 1 to a + T.
+  uint64_t count = 0;
+  if (myProcRank == 0) {
+    const uint64_t a = primes.size() - 1;
+    const uint64_t numP2 = total[1];
+    count = total[0] + a - 1 + numP2 * a + numP2 * (numP2 - 1) / 2;
+  }
+  MPI_Bcast(&count, 1, MPI_UINT64_T, 0, config->comm);
+  return count;
+}
+
+void lmoCounter::buildTables() noexcept(false)
+{
+  // Every process sieves the primes up to y by itself. That is
+  // about x^(1/3), next to nothing.
+  const sieveConfig localConfig = getLocalConfig();
+  primes.assign(1, 0);
+  vectorSink<primeT> sink(&primes);
+  uint64_t numFound = 0;
+  eratSieve<primeT>(cinfo, &localConfig, 0, y, &sink, &numFound);
+
+  pi.assign(y + 1, 0);
+  mu.assign(y + 1, 1);
+  lpf.assign(y + 1, 0);
+  for (size_t i = 1; i < primes.size(); ++i) {
+    const primeT prime = primes[i];
+    pi[prime] = i;
+    for (primeT m = prime; m <= y; m += prime) {
+      if (lpf[m] == 0) {
+        lpf[m] = prime;
+      }
+      mu[m] = -mu[m];
+    }
+    for (primeT m = prime * prime; m <= y; m += prime * prime) {
+      mu[m] = 0;
+    }
+  }
+  for (primeT n = 1; n <= y; ++n) {
+    if (pi[n] == 0) {
+      pi[n] = pi[n - 1];
+    }
+  }
+  lpf[1] = numeric_limits<uint32_t>::max();
+}
+
+uint64_t lmoCounter::computeS1() const
+{
+  // The ordinary leaves are mu(m) phi(x / m, 3), for the squarefree
+  // m up to y with no wheel prime factor. phi(n, 3) is the number of
+  // bits of a wheelSegment up to n.
+  uint64_t sum = 0;
+  for (primeT m = 1 + myProcRank; m <= y; m += commSz) {
+    if (mu[m] == 0 || lpf[m] <= primes[knumWheelPrimes]) {
+      continue;
+    }
+    const uint64_t phi = DS::wheelSegment::offsetToBit(x / m + 1);
+    sum += mu[m] > 0 ? phi : -phi;
+  }
+  return sum;
+}
+
+uint64_t lmoCounter::computeS2() noexcept(false)
+{
+  // Each process takes a run of consecutive segments, and each of
+  // its threads a run of those.
+  const primeT segSpan =
+    static_cast<primeT>(DS::wheelSegment::kwheelSz) * getSegmentBytes();
+  const size_t numSegs = z / segSpan + 1;
+  const size_t myFirstSeg = numSegs * myProcRank / commSz;
+  const size_t myLastSeg = numSegs * (myProcRank + 1) / commSz;
+
+  const size_t numThreads = pool.size();
+  vector<leafSlab> slabs(numThreads);
+  pool.run(numThreads, [&](const unsigned, const size_t t) {
+      sieveLeaves(myFirstSeg + (myLastSeg - myFirstSeg) * t / numThreads,
+                  myFirstSeg +
+                    (myLastSeg - myFirstSeg) * (t + 1) / numThreads,
+                  &slabs[t]);
+    });
+
+  // Each slab counted phi from its own left limit. The leaves of a
+  // slab are short of what the slabs before it counted, once per
+  // leaf and with the sign of the leaf.
+  const size_t numB = primes.size();
+  vector<uint64_t> phi(numB, 0);
+  vector<uint64_t> muSum(numB, 0);
+  uint64_t sum = 0;
+  for (const leafSlab& slab : slabs) {
+    sum += slab.sum;
+    for (size_t b = 0; b < numB; ++b) {
+      sum += phi[b] * slab.muSum[b];
+      phi[b] += slab.phi[b];
+      muSum[b] += slab.muSum[b];
+    }
+  }
+
+  // Likewise for the processes.
+  vector<uint64_t> phiBefore(numB, 0);
+  MPI_Exscan(phi.data(), phiBefore.data(), numB, MPI_UINT64_T, MPI_SUM,
+             config->comm);
+  if (myProcRank != 0) {
+    for (size_t b = 0; b < numB; ++b) {
+      sum += phiBefore[b] * muSum[b];
+    }
+  }
+
+  return sum;
+}
+
+void lmoCounter::sieveLeaves(const size_t firstSeg,
+                             const size_t lastSeg,
+                             leafSlab* slab) const
+{
+  const size_t numB = primes.size();
+  slab->phi.assign(numB, 0);
+  slab->muSum.assign(numB, 0);
+  slab->sum = 0;
+
+  const size_t piY = primes.size() - 1;
+  const size_t piSqrtY = pi[num<primeT>::isqrt(y)];
+  DS::wheelSegment segment(getSegmentBytes());
+
+  for (size_t seg = firstSeg; seg < lastSeg; ++seg) {
+    const primeT low = seg * segment.span();
+    const primeT high = low + segment.span();
+    segment.reset();
+
+    // At the time primes[b] is looked at, the segment has the
+    // multiples of every prime before it marked. The special
+    // leaves of primes[b] are -mu(m) phi(x / (primes[b] m), b - 1),
+    // for the m up to y with m primes[b] > y, and no prime factor up
+    // to primes[b]. Those with x / (primes[b] m) in the segment are
+    // counted here.
+    for (size_t b = knumWheelPrimes + 1; b < piY; ++b) {
+      const primeT prime = primes[b];
+      const primeT maxM =
+        low == 0 ? y : num<primeT>::min(x / (prime * low), y);
+      // No leaves here, nor in any later segment, for this prime or
+      // the ones after it.
+      if (prime >= maxM) {
+        break;
+      }
+      const primeT minM = num<primeT>::min(
+        num<primeT>::max(x / (prime * high), y / prime), y);
+
+      // x / (prime m) grows as m goes down, so the count of the
+      // unmarked numbers up to it only ever moves right.
+      size_t curBit = 0;
+      uint64_t curCount = 0;
+      const auto getPhi = [&](const primeT n) {
+        const size_t bit = DS::wheelSegment::offsetToBit(x / n - low + 1);
+        curCount += segment.countUnmarked(curBit, bit);
+        curBit = bit;
+        return slab->phi[b] + curCount;
+      };
+
+      if (b < piSqrtY) {
+        for (primeT m = maxM; m > minM; --m) {
+          if (mu[m] == 0 || lpf[m] <= prime) {
+            continue;
+          }
+          const uint64_t phi = getPhi(prime * m);
+          if (mu[m] > 0) {
+            slab->sum -= phi;
+            --slab->muSum[b];
+          }
+          else {
+            slab->sum += phi;
+            ++slab->muSum[b];
+          }
+        }
+      }
+      else {
+        // Past sqrt(y), m can only be a prime greater than prime.
+        for (size_t l = pi[maxM];
+             l > pi[num<primeT>::max(minM, prime)]; --l) {
+          slab->sum += getPhi(prime * primes[l]);
+          ++slab->muSum[b];
+        }
+      }
+
+      slab->phi[b] += curCount +
+        segment.countUnmarked(curBit, segment.numBits());
+
+      // phi counts the primes themselves out as well.
+      if (prime >= low && prime < high) {
+        segment.mark(DS::wheelSegment::offsetToBit(prime - low));
+      }
+      segment.markMultiples(prime, low);
+    }
+  }
+}
+
+uint64_t lmoCounter::computeP2(uint64_t* numP2Primes) noexcept(false)
+{
+  *numP2Primes = 0;
+  const primeT sqrtX = num<primeT>::isqrt(x);
+  if (sqrtX <= y) {
+    return 0;
+  }
+
+  // x / p lands in [sqrtX, z] for every prime p of P2. The processes
+  // split it evenly, and count the primes of their own slab. What
+  // comes before sqrtX is counted first, by all of them.
+  sieveConfig countConfig = *config;
+  countConfig.countOnly = true;
+  countConfig.rankLocalOutput = false;
+  uint64_t numBelow = 0;
+  eratSieve<primeT>(cinfo, &countConfig, 0, sqrtX - 1, nullptr,
+                    &numBelow);
+  MPI_Bcast(&numBelow, 1, MPI_UINT64_T, 0, config->comm);
+
+  const primeT slabSz = (z - sqrtX + commSz) / commSz;
+  const primeT myLeftLim =
+    num<primeT>::min(sqrtX + myProcRank * slabSz, z + 1);
+  const primeT myRightLim = num<primeT>::min(myLeftLim + slabSz, z + 1);
+
+  const sieveConfig localConfig = getLocalConfig();
+  uint64_t sum = 0;
+  uint64_t myCount = 0;
+  for (primeT left = myLeftLim; left < myRightLim;
+       left += kp2ChunkSpan) {
+    const primeT right = num<primeT>::min(left + kp2ChunkSpan,
+                                          myRightLim);
+
+    // x / p is in [left, right) for the primes p in
+    // (x / right, x / left].
+    vector<primeT> p2Primes;
+    const primeT pLeftLim = num<primeT>::max(y, x / right) + 1;
+    const primeT pRightLim = num<primeT>::min(sqrtX, x / left);
+    if (pLeftLim <= pRightLim) {
+      vectorSink<primeT> sink(&p2Primes);
+      uint64_t numFound = 0;
+      eratSieve<primeT>(cinfo, &localConfig, pLeftLim, pRightLim,
+                        &sink, &numFound);
+    }
+    vector<primeT> targets(p2Primes.size());
+    for (size_t i = 0; i < p2Primes.size(); ++i) {
+      targets[i] = x / p2Primes[p2Primes.size() - 1 - i];
+    }
+
+    piSink sink(targets, myCount);
+    uint64_t numFound = 0;
+    eratSieve<primeT>(cinfo, &localConfig, left, right - 1, &sink,
+                      &numFound);
+    sum += sink.getSum();
+    *numP2Primes += p2Primes.size();
+    myCount += numFound;
+  }
+
+  uint64_t countBefore = 0;
+  MPI_Exscan(&myCount, &countBefore, 1, MPI_UINT64_T, MPI_SUM,
+             config->comm);
+  if (myProcRank == 0) {
+    countBefore = 0;
+  }
+
+  return sum + *numP2Primes * (numBelow + countBefore);
+}
+
+sieveConfig lmoCounter::getLocalConfig() const
+{
+  sieveConfig localConfig = *config;
+  localConfig.countOnly = false;
+  localConfig.rankLocalOutput = false;
+  localConfig.comm = MPI_COMM_SELF;
+  return localConfig;
+}
+
+size_t lmoCounter::getSegmentBytes() const
+{
+  // Every prime of the leaves walks the whole segment to count it,
+  // so segments should be large, but no larger than [0, z] needs.
+  return num<primeT>::min(z / DS::wheelSegment::kwheelSz + 1,
+                          kmaxSegmentBytes);
+}
+
+primeT lmoCounter::getY(const primeT x)
+{
+  // Larger y move work from the sieve of S2 to the leaves.
+  const primeT cbrtX = num<primeT>::icbrt(x);
+  const primeT y = static_cast<primeT>(kalpha * cbrtX);
+  return num<primeT>::max(
+    1, num<primeT>::max(cbrtX,
+                        num<primeT>::min(y, num<primeT>::isqrt(x))));
+}
+
+}
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: implementation of class ~nthPrime~. See header file
+// for more detail.
+//===----------------------------------------------------------===//
+
+#include "Alg/nthPrime.hpp"
+
+#include "Alg/primeCounter.hpp"
+#include "Alg/vectorSink.hpp"
+#include "Utils/num.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace Utils;
+
+namespace Alg {
+
+constexpr uint64_t nthPrime::kmaxIndex;
+
+primeT nthPrime::find(const cacheInfo* cinfo,
+                      const sieveConfig& config, const uint64_t n)
+  noexcept(false)
+{
+  num<uint64_t>::checkInRange(n, 1, kmaxIndex);
+  const primeT leftLim = getLowerBound(n);
+  const primeT rightLim = getUpperBound(n);
+
+  // Everything below the lower bound is only counted.
+  const uint64_t numBelow = leftLim > 0 ?
+    primeCounter::count(cinfo, config, 0, leftLim - 1) : 0;
+
+  // p_n is then the (n - numBelow)-th prime of [leftLim, rightLim].
+  sieveConfig listConfig = config;
+  listConfig.countOnly = false;
+  listConfig.rankLocalOutput = false;
+  vector<primeT> primes;
+  vectorSink<primeT> sink(&primes);
+  uint64_t numFound = 0;
+  eratSieve<primeT>(cinfo, &listConfig, leftLim, rightLim, &sink,
+                    &numFound);
+
+  int myProcRank;
+  MPI_Comm_rank(config.comm, &myProcRank);
+  primeT prime = 0;
+  if (myProcRank == 0 && n - numBelow <= primes.size()) {
+    prime = primes[n - numBelow - 1];
+  }
+  MPI_Bcast(&prime, 1, MPI_UINT64_T, 0, config.comm);
+  if (prime == 0) {
+    throw logic_error{
+      "The bounds of the prime of index " + to_string(n) +
+        " missed it"};
+  }
+
+  return prime;
+}
+
+primeT nthPrime::getLowerBound(const uint64_t n)
+{
+  // p_n >= n (ln n + ln ln n - 1 + (ln ln n - 2.25) / ln n), for
+  // n >= 2 (Dusart, 1999).
+  if (n < 2) {
+    return 0;
+  }
+  const long double logN = logl(n);
+  const long double logLogN = logl(logN);
+  const long double bound = n * (logN + logLogN - 1
+                                 + (logLogN - 2.25L) / logN);
+  return bound > 0 ? static_cast<primeT>(bound * (1 - kboundSlack)) : 0;
+}
+
+primeT nthPrime::getUpperBound(const uint64_t n)
+{
+  // The bound below only holds from p_6 = 13 on.
+  if (n < 6) {
+    return 11;
+  }
+
+  // p_n <= n (ln n + ln ln n - 1 + (ln ln n - 1.8) / ln n), for
+  // n >= 27076, and p_n <= n (ln n + ln ln n), for n >= 6 (Dusart,
+  // 1999).
+  const long double logN = logl(n);
+  const long double logLogN = logl(logN);
+  const long double bound = n < kminTightUpperIndex ?
+    n * (logN + logLogN) :
+    n * (logN + logLogN - 1 + (logLogN - 1.8L) / logN);
+
+  const long double slackBound = bound * (1 + kboundSlack) + 1;
+  return slackBound < kmaxPrime ?
+    static_cast<primeT>(slackBound) : kmaxPrime;
+}
+
+}
@@ -0,0 +1,46 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: implementation of class ~primeCounter~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Alg/primeCounter.hpp"
+
+#include "Alg/lmoCounter.hpp"
+
+using namespace std;
+using namespace Utils;
+
+namespace Alg {
+
+uint64_t primeCounter::count(const cacheInfo* cinfo,
+                             const sieveConfig& config,
+                             const primeT leftLim,
+                             const primeT rightLim) noexcept(false)
+{
+  const bool useLmo = config.counter == countMethod::lmo ||
+    (config.counter == countMethod::automatic &&
+     lmoCounter::beatsSieve(leftLim, rightLim));
+
+  if (useLmo) {
+    uint64_t numUpToRight = 0;
+    uint64_t numBelowLeft = 0;
+    lmoCounter(cinfo, &config, rightLim, &numUpToRight);
+    if (leftLim > 0) {
+      lmoCounter(cinfo, &config, leftLim - 1, &numBelowLeft);
+    }
+    return numUpToRight - numBelowLeft;
+  }
+
+  sieveConfig countConfig = config;
+  countConfig.countOnly = true;
+  countConfig.rankLocalOutput = false;
+  uint64_t numPrimes = 0;
+  eratSieve<primeT>(cinfo, &countConfig, leftLim, rightLim, nullptr,
+                    &numPrimes);
+  MPI_Bcast(&numPrimes, 1, MPI_UINT64_T, 0, config.comm);
+  return numPrimes;
+}
+
+}
@@ -0,0 +1,90 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: implementation of class ~segmentTuner~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Alg/segmentTuner.hpp"
+#include "Utils/error.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+using namespace std;
+using namespace Utils;
+
+namespace Alg {
+
+vector<size_t> segmentTuner::getCandidates()
+{
+  // Half and whole of each cache level. The L3 is shared by every
+  // core, so only a fraction of it is tried.
+  vector<size_t> candidates;
+  const auto addCandidate = [&candidates](const long bytes) {
+    if (bytes >= static_cast<long>(kminCandidateBytes)) {
+      candidates.push_back(bytes);
+    }
+  };
+
+  cacheInfo l1, l2, l3;
+  hwInfo::fetchCacheInfo(&l1, LEVEL1, DATA_CACHE);
+  hwInfo::fetchCacheInfo(&l2, LEVEL2, DATA_CACHE);
+  hwInfo::fetchCacheInfo(&l3, LEVEL3, DATA_CACHE);
+  addCandidate(l1.size / 2);
+  addCandidate(l1.size);
+  addCandidate(l2.size / 4);
+  addCandidate(l2.size / 2);
+  addCandidate(l2.size);
+  addCandidate(l3.size / 8);
+
+  if (candidates.empty()) {
+    candidates.push_back(16384);
+  }
+  sort(candidates.begin(), candidates.end());
+  candidates.erase(unique(candidates.begin(), candidates.end()),
+                   candidates.end());
+
+  return candidates;
+}
+
+size_t segmentTuner::findBestWindowBytes(const cacheInfo* cinfo,
+                                         const sieveConfig& config,
+                                         const primeT leftLim,
+                                         const primeT rightLim)
+{
+  sieveConfig tuneConfig = config;
+  tuneConfig.countOnly = true;
+
+  size_t bestBytes = 0;
+  double bestTime = numeric_limits<double>::max();
+  for (const size_t candidate : getCandidates()) {
+    tuneConfig.windowBytes = candidate;
+
+    double candidateTime = numeric_limits<double>::max();
+    for (unsigned i = 0; i < knumRepetitions; ++i) {
+      // Every process has to be done with the previous run, or the
+      // time would also measure the wait for the slowest one.
+      MPI_Barrier(tuneConfig.comm);
+      uint64_t numPrimes = 0;
+      const auto start = chrono::steady_clock::now();
+      eratSieve<primeT>(cinfo, &tuneConfig, leftLim, rightLim,
+                        nullptr, &numPrimes);
+      const chrono::duration<double> elapsed =
+        chrono::steady_clock::now() - start;
+      candidateTime = min(candidateTime, elapsed.count());
+    }
+
+    LOG(ALG_SEGMENTTUNER_DEBUG, "(segmentTuner) %zu bytes: %f s",
+        candidate, candidateTime);
+    if (candidateTime < bestTime) {
+      bestTime = candidateTime;
+      bestBytes = candidate;
+    }
+  }
+
+  return bestBytes;
+}
+
+}
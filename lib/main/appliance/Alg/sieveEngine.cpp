@@ -0,0 +1,107 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: implementation of class ~sieveEngine~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Alg/sieveEngine.hpp"
+
+#include "Alg/atkinProducer.hpp"
+#include "Alg/eratProducer.hpp"
+#include "Alg/eratSieve.hpp"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace Alg {
+
+namespace {
+
+template <typename primeType>
+unique_ptr<segmentProducer<primeType>> createErat(
+  const size_t windowBytes)
+{
+  return unique_ptr<segmentProducer<primeType>>{
+    new eratProducer<primeType>(windowBytes)};
+}
+
+template <typename primeType>
+unique_ptr<segmentProducer<primeType>> createAtkin(const size_t)
+{
+  return unique_ptr<segmentProducer<primeType>>{
+    new atkinProducer<primeType>()};
+}
+
+template <typename primeType>
+bool suitsAll(const primeType, const primeType)
+{
+  return true;
+}
+
+}
+
+template <typename primeType>
+vector<typename sieveEngine<primeType>::entry>&
+sieveEngine<primeType>::getEntries()
+{
+  static vector<entry> entries{
+    {"eratosthenes", createErat<primeType>, suitsAll<primeType>},
+    {"atkin", createAtkin<primeType>, nullptr}
+  };
+  return entries;
+}
+
+template <typename primeType>
+void sieveEngine<primeType>::add(const string& name,
+                                 const createFn create,
+                                 const suitsFn suits) noexcept(false)
+{
+  for (const entry& e : getEntries()) {
+    if (e.name == name) {
+      throw invalid_argument{"Engine '" + name + "' already exists"};
+    }
+  }
+  getEntries().push_back(entry{name, create, suits});
+}
+
+template <typename primeType>
+const typename sieveEngine<primeType>::entry&
+sieveEngine<primeType>::find(const string& name) noexcept(false)
+{
+  for (const entry& e : getEntries()) {
+    if (e.name == name) {
+      return e;
+    }
+  }
+  throw invalid_argument{"Unknown engine '" + name + '\''};
+}
+
+template <typename primeType>
+const typename sieveEngine<primeType>::entry&
+sieveEngine<primeType>::pick(const primeType leftLim,
+                             const primeType rightLim)
+{
+  const vector<entry>& entries = getEntries();
+  for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+    if (it->suits && it->suits(leftLim, rightLim)) {
+      return *it;
+    }
+  }
+  return entries.front();
+}
+
+template <typename primeType>
+vector<string> sieveEngine<primeType>::getNames()
+{
+  vector<string> names;
+  for (const entry& e : getEntries()) {
+    names.push_back(e.name);
+  }
+  return names;
+}
+
+template class sieveEngine<primeT>;
+
+}
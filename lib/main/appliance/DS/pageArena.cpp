@@ -0,0 +1,112 @@
+//===----------------------------------------------------------===//
+// DS module
+//
+// File purpose: implementation of class ~pageArena~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "DS/pageArena.hpp"
+
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include <sys/mman.h>
+
+using namespace std;
+
+namespace DS {
+
+constexpr size_t pageArena::khugePageBytes;
+
+pageArena::pageArena()
+  : base(nullptr), numBytes(0)
+{}
+
+pageArena::pageArena(const size_t numBytes) noexcept(false)
+  : pageArena()
+{
+  reserve(numBytes);
+}
+
+pageArena::~pageArena()
+{
+  unmap();
+}
+
+pageArena::pageArena(pageArena&& rhs) noexcept
+  : base(rhs.base), numBytes(rhs.numBytes)
+{
+  rhs.base = nullptr;
+  rhs.numBytes = 0;
+}
+
+pageArena& pageArena::operator=(pageArena&& rhs) noexcept
+{
+  swap(base, rhs.base);
+  swap(numBytes, rhs.numBytes);
+  return *this;
+}
+
+void pageArena::reserve(const size_t minBytes) noexcept(false)
+{
+  if (minBytes <= numBytes) {
+    return;
+  }
+  unmap();
+
+  // Huge pages only come in whole pages.
+  const bool huge = minBytes >= khugePageBytes;
+  const size_t mapBytes = huge ?
+    (minBytes + khugePageBytes - 1) / khugePageBytes * khugePageBytes :
+    minBytes;
+
+  void* addr = MAP_FAILED;
+#ifdef MAP_HUGETLB
+  if (huge) {
+    addr = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  }
+#endif
+  if (addr == MAP_FAILED) {
+    addr = mmap(nullptr, mapBytes, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+      throw bad_alloc{};
+    }
+    if (huge) {
+      adviseHugePages(addr, mapBytes);
+    }
+  }
+
+  base = addr;
+  numBytes = mapBytes;
+}
+
+void pageArena::adviseHugePages(void* addr, const size_t numBytes)
+{
+#ifdef MADV_HUGEPAGE
+  // Only the pages that lie entirely inside the buffer, since the
+  // advice holds for whole pages.
+  const uintptr_t first = reinterpret_cast<uintptr_t>(addr);
+  const uintptr_t alignedFirst =
+    (first + khugePageBytes - 1) / khugePageBytes * khugePageBytes;
+  const uintptr_t alignedLast =
+    (first + numBytes) / khugePageBytes * khugePageBytes;
+  if (alignedFirst < alignedLast) {
+    madvise(reinterpret_cast<void*>(alignedFirst),
+            alignedLast - alignedFirst, MADV_HUGEPAGE);
+  }
+#endif
+}
+
+void pageArena::unmap()
+{
+  if (base) {
+    munmap(base, numBytes);
+    base = nullptr;
+    numBytes = 0;
+  }
+}
+
+}
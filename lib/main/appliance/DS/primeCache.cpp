@@ -0,0 +1,182 @@
+//===----------------------------------------------------------===//
+// DS module
+//
+// File purpose: implementation of class ~primeCache~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "DS/primeCache.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace DS {
+
+constexpr char primeCache::kmagic[4];
+
+namespace {
+
+// Holds an exclusive lock on a file for as long as it lives. Every
+// change to the size of the file happens under it, so that nobody
+// ever shrinks it, and so does every block that is stored, so that
+// nobody overwrites one that is present.
+class fileLock {
+public:
+  explicit fileLock(const int fd)
+    : fd(fd)
+  {
+    flock(fd, LOCK_EX);
+  }
+
+  ~fileLock()
+  {
+    flock(fd, LOCK_UN);
+  }
+
+private:
+  const int fd;
+};
+
+uint64_t getFileBytes(const int fd, const string& path) noexcept(false)
+{
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    throw runtime_error{"Could not stat " + path};
+  }
+  return st.st_size;
+}
+
+}
+
+primeCache::primeCache(const string& path) noexcept(false)
+  : path(path), fd(-1), mapping(nullptr), mappedBytes(0)
+{
+  fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    throw runtime_error{"Could not open " + path};
+  }
+
+  {
+    fileLock lock(fd);
+    char header[kheaderBytes] = {};
+    if (getFileBytes(fd, path) == 0) {
+      const uint32_t blockBytes = kblockBytes;
+      memcpy(header, kmagic, sizeof(kmagic));
+      memcpy(header + 4, &kversion, sizeof(kversion));
+      memcpy(header + 8, &blockBytes, sizeof(blockBytes));
+      if (pwrite(fd, header, kheaderBytes, 0) !=
+          static_cast<ssize_t>(kheaderBytes)) {
+        close(fd);
+        throw runtime_error{"Could not write " + path};
+      }
+    }
+    else {
+      uint32_t version = 0;
+      uint32_t blockBytes = 0;
+      if (pread(fd, header, kheaderBytes, 0) !=
+            static_cast<ssize_t>(kheaderBytes) ||
+          memcmp(header, kmagic, sizeof(kmagic)) != 0) {
+        close(fd);
+        throw runtime_error{path + ": not a prime cache"};
+      }
+      memcpy(&version, header + 4, sizeof(version));
+      memcpy(&blockBytes, header + 8, sizeof(blockBytes));
+      if (version != kversion || blockBytes != kblockBytes) {
+        close(fd);
+        throw runtime_error{path + ": unknown version " +
+                            to_string(version)};
+      }
+    }
+  }
+
+  map();
+}
+
+primeCache::~primeCache()
+{
+  unmap();
+  close(fd);
+}
+
+void primeCache::reserve(uint64_t numBlocks) noexcept(false)
+{
+  numBlocks = numBlocks < kmaxBlocks ? numBlocks : kmaxBlocks;
+  if (numBlocks <= getNumBlocks()) {
+    return;
+  }
+
+  {
+    fileLock lock(fd);
+    const uint64_t bytes = kheaderBytes + numBlocks * getRecordBytes();
+    if (getFileBytes(fd, path) < bytes &&
+        ftruncate(fd, bytes) != 0) {
+      throw runtime_error{"Could not grow " + path};
+    }
+  }
+
+  unmap();
+  map();
+}
+
+bool primeCache::hasBlock(const uint64_t blockIdx) const
+{
+  return blockIdx < getNumBlocks() &&
+    __atomic_load_n(reinterpret_cast<const uint32_t*>(
+                      getRecord(blockIdx)), __ATOMIC_ACQUIRE) != 0;
+}
+
+uint32_t primeCache::getCount(const uint64_t blockIdx) const
+{
+  return __atomic_load_n(reinterpret_cast<const uint32_t*>(
+                           getRecord(blockIdx)), __ATOMIC_ACQUIRE) - 1;
+}
+
+void primeCache::load(const uint64_t blockIdx,
+                      wheelSegment* segment) const
+{
+  memcpy(segment->data(), getRecord(blockIdx) + kheaderBytes,
+         kblockBytes);
+}
+
+void primeCache::store(const uint64_t blockIdx,
+                       const wheelSegment& block, const uint32_t count)
+{
+  fileLock lock(fd);
+  if (hasBlock(blockIdx)) {
+    return;
+  }
+  // Readers do not take the lock, so the count goes last.
+  memcpy(getRecord(blockIdx) + kheaderBytes, block.data(), kblockBytes);
+  __atomic_store_n(reinterpret_cast<uint32_t*>(getRecord(blockIdx)),
+                   count + 1, __ATOMIC_RELEASE);
+}
+
+void primeCache::map() noexcept(false)
+{
+  mappedBytes = getFileBytes(fd, path);
+  void* const addr = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    mappedBytes = 0;
+    throw runtime_error{"Could not map " + path};
+  }
+  mapping = static_cast<uint8_t*>(addr);
+}
+
+void primeCache::unmap()
+{
+  if (mapping != nullptr) {
+    munmap(mapping, mappedBytes);
+    mapping = nullptr;
+  }
+}
+
+}
@@ -0,0 +1,61 @@
+//===----------------------------------------------------------===//
+// DS module
+//
+// File purpose: implementation of class ~tupletPattern~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "DS/tupletPattern.hpp"
+#include "DS/wheelSegment.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace DS {
+
+constexpr unsigned tupletPattern::kmaxNumbers;
+
+tupletPattern::tupletPattern()
+  : maxOffset(0)
+{}
+
+tupletPattern::tupletPattern(const vector<vector<unsigned>>& forms)
+  noexcept(false)
+  : maxOffset(0)
+{
+  const unsigned kwheelSz = wheelSegment::kwheelSz;
+  for (const vector<unsigned>& form : forms) {
+    if (form.empty() || form.size() > kmaxNumbers || form[0] != 0) {
+      throw invalid_argument{"Invalid tuplet form"};
+    }
+    for (size_t i = 1; i < form.size(); ++i) {
+      // Shifts have to stay inside the word after the start.
+      if (form[i] <= form[i - 1] || form[i] >= kwheelSz * 7) {
+        throw invalid_argument{"Invalid tuplet form"};
+      }
+    }
+    maxOffset = max(maxOffset, form.back());
+
+    for (unsigned idx = 0; idx < wheelSegment::knumResidues; ++idx) {
+      const unsigned residue = wheelSegment::bitToOffset(idx);
+      shape s;
+      s.startMask = 0x0101010101010101ULL << idx;
+      s.numShifts = 0;
+      bool fits = true;
+      for (size_t i = 1; i < form.size() && fits; ++i) {
+        const unsigned number = residue + form[i];
+        fits = wheelSegment::bitToOffset(
+          wheelSegment::offsetToBit(number)) == number;
+        s.shifts[s.numShifts++] =
+          wheelSegment::offsetToBit(number) - idx;
+      }
+      if (fits) {
+        shapes.push_back(s);
+      }
+    }
+  }
+}
+
+}
@@ -0,0 +1,163 @@
+//===----------------------------------------------------------===//
+// DS module
+//
+// File purpose: implementation of class ~wheelSegment~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "DS/wheelSegment.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+namespace DS {
+
+namespace {
+
+// Marks of the multiples of the presieve primes over one period,
+// i.e. over their product times the wheel size. Built on first use.
+const vector<uint8_t>& getPresievePattern()
+{
+  static const vector<uint8_t> pattern = [] {
+    uint64_t periodBytes = 1;
+    for (const uint8_t prime : wheelSegment::kpresievePrimes) {
+      periodBytes *= prime;
+    }
+
+    wheelSegment period(periodBytes);
+    for (const uint8_t prime : wheelSegment::kpresievePrimes) {
+      for (uint64_t mul = 1; prime * mul < period.span();
+           mul = wheelSegment::nextCoprime(mul + 1)) {
+        period.mark(wheelSegment::offsetToBit(prime * mul));
+      }
+    }
+    return vector<uint8_t>(period.data(),
+                           period.data() + period.numBytes());
+  }();
+
+  return pattern;
+}
+
+}
+
+const uint8_t wheelSegment::kpresievePrimes[knumPresievePrimes] = {
+  7, 11, 13, 17, 19
+};
+
+const uint8_t wheelSegment::kresidues[knumResidues] = {
+  1, 7, 11, 13, 17, 19, 23, 29
+};
+
+const uint8_t wheelSegment::kresidueRank[kwheelSz] = {
+  0, 0, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 4,
+  4, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7, 7, 7
+};
+
+const wheelSegment::wheelStep
+wheelSegment::kwheelSteps[knumResidues][knumResidues] = {
+  { {6, 0, 0x01}, {4, 0, 0x02}, {2, 0, 0x04}, {4, 0, 0x08},
+    {2, 0, 0x10}, {4, 0, 0x20}, {6, 0, 0x40}, {2, 1, 0x80} },
+  { {6, 1, 0x02}, {4, 1, 0x20}, {2, 1, 0x10}, {4, 0, 0x01},
+    {2, 1, 0x80}, {4, 1, 0x08}, {6, 1, 0x04}, {2, 1, 0x40} },
+  { {6, 2, 0x04}, {4, 2, 0x10}, {2, 0, 0x01}, {4, 2, 0x40},
+    {2, 0, 0x02}, {4, 2, 0x80}, {6, 2, 0x08}, {2, 1, 0x20} },
+  { {6, 3, 0x08}, {4, 1, 0x01}, {2, 1, 0x40}, {4, 2, 0x20},
+    {2, 1, 0x04}, {4, 1, 0x02}, {6, 3, 0x80}, {2, 1, 0x10} },
+  { {6, 3, 0x10}, {4, 3, 0x80}, {2, 1, 0x02}, {4, 2, 0x04},
+    {2, 1, 0x20}, {4, 3, 0x40}, {6, 3, 0x01}, {2, 1, 0x08} },
+  { {6, 4, 0x20}, {4, 2, 0x08}, {2, 2, 0x80}, {4, 2, 0x02},
+    {2, 2, 0x40}, {4, 2, 0x01}, {6, 4, 0x10}, {2, 1, 0x04} },
+  { {6, 5, 0x40}, {4, 3, 0x04}, {2, 1, 0x08}, {4, 4, 0x80},
+    {2, 1, 0x01}, {4, 3, 0x10}, {6, 5, 0x20}, {2, 1, 0x02} },
+  { {6, 6, 0x80}, {4, 4, 0x40}, {2, 2, 0x20}, {4, 4, 0x10},
+    {2, 2, 0x08}, {4, 4, 0x04}, {6, 6, 0x02}, {2, 1, 0x01} }
+};
+
+void wheelSegment::presieve(const uint64_t leftLim)
+{
+  // The pattern repeats itself every pattern.size() bytes, so the
+  // segment is just a rotated copy of it.
+  const vector<uint8_t>& pattern = getPresievePattern();
+  uint8_t* const bytes = data();
+  size_t patternPos = leftLim / kwheelSz % pattern.size();
+  for (size_t pos = 0; pos < segBytes;) {
+    const size_t chunk =
+      min(segBytes - pos, pattern.size() - patternPos);
+    memcpy(&bytes[pos], &pattern[patternPos], chunk);
+    pos += chunk;
+    patternPos = 0;
+  }
+
+  if (leftLim == 0) {
+    for (const uint8_t prime : kpresievePrimes) {
+      const size_t bit = offsetToBit(prime);
+      if (bit < numBits()) {
+        words[bit / kwordBits] &= ~(uint64_t{1} << (bit % kwordBits));
+      }
+    }
+  }
+}
+
+size_t wheelSegment::countUnmarked(const size_t firstBit,
+                                   const size_t lastBit) const
+{
+  if (firstBit >= lastBit) {
+    return 0;
+  }
+
+  const size_t firstWord = firstBit / kwordBits;
+  const size_t lastWord = (lastBit - 1) / kwordBits;
+  const uint64_t headMask = ~uint64_t{0} << (firstBit % kwordBits);
+  const uint64_t tailMask =
+    ~uint64_t{0} >> (kwordBits - 1 - (lastBit - 1) % kwordBits);
+
+  if (firstWord == lastWord) {
+    return (lastBit - firstBit) -
+      __builtin_popcountll(words[firstWord] & headMask & tailMask);
+  }
+
+  size_t numMarked = __builtin_popcountll(words[firstWord] & headMask);
+  for (size_t wordIdx = firstWord + 1; wordIdx < lastWord; ++wordIdx) {
+    numMarked += __builtin_popcountll(words[wordIdx]);
+  }
+  numMarked += __builtin_popcountll(words[lastWord] & tailMask);
+
+  return (lastBit - firstBit) - numMarked;
+}
+
+void wheelSegment::markMultiples(const uint64_t prime,
+                                 const uint64_t leftLim)
+{
+  const uint64_t rightLim = leftLim + span();
+  uint8_t* const bytes = data();
+
+  // Smallest multiplier whose multiple lies inside the segment.
+  // Multiples below prime * prime have a smaller factor, so they are
+  // marked by some other prime.
+  uint64_t minMul = (leftLim + prime - 1) / prime;
+  if (minMul < prime) {
+    minMul = prime;
+  }
+
+  // prime * (m + 30) = prime * m + 30 * prime, so every one of the 8
+  // classes of multipliers walks the segment with a stride of
+  // ~prime~ bytes, always hitting the same bit.
+  for (unsigned i = 0; i < knumResidues; ++i) {
+    const uint64_t mul = minMul +
+      (kresidues[i] + kwheelSz - minMul % kwheelSz) % kwheelSz;
+    const uint64_t multiple = prime * mul;
+    if (multiple >= rightLim) {
+      continue;
+    }
+
+    const uint64_t offset = multiple - leftLim;
+    const uint8_t mask = 1 << kresidueRank[offset % kwheelSz];
+    for (size_t pos = offset / kwheelSz; pos < segBytes;
+         pos += prime) {
+      bytes[pos] |= mask;
+    }
+  }
+}
+
+}
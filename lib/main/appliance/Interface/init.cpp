@@ -7,37 +7,82 @@
 
 #include "Interface/init.hpp"
 
+#include "Alg/cachedSieve.hpp"
 #include "Alg/eratSieve.hpp"
+#include "Alg/nthPrime.hpp"
+#include "Alg/primeCounter.hpp"
+#include "Alg/segmentTuner.hpp"
+#include "Alg/sieveEngine.hpp"
+#include "Interface/outputSink.hpp"
+#include "Interface/tuneFile.hpp"
 #include "Utils/error.hpp"
 #include "Utils/file.hpp"
 #include "Utils/num.hpp"
+#include "Utils/profiler.hpp"
 
+#include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 
 using namespace Utils;
 using namespace std;
-using primeT = unsigned;
 
 namespace Interface {
 
 init::init(int argc, char** argv) 
-  : arrRightLim(0), outMode('\0'), shouldPrintList(false), 
-    shouldPrintTime(false), clkVar(0)
+  : arrLeftLim(0), arrRightLim(0), tunePath(kdefaultTunePath),
+    autotuneSpan(0), binaryOutput(false),
+    outFormat(primeFile::format::varint), nthIndex(0),
+    shouldPrintList(false), shouldPrintTime(false),
+    shouldPrintCount(false), shouldPrintNth(false), clkVar(0),
+    numPrimes(0), nthPrimeFound(0)
 {
   setMPIVariables();
-  allocatePrimesList();
 
   // TODO: not separating argc/argv reading into processes might
   // produce a bug.
   setAndValidateArguments(argc, argv);
   processEntries(argc, argv);
+  if (!profilePath.empty()) {
+    profiler::enable(true);
+  }
+
+  run();
 
-  TIME_EXECUTION(clkVar, 
-                 Alg::eratSieve(&cinfo, 
-                                static_cast<unsigned>(arrRightLim),
-                                primesList));
+  if (!profilePath.empty()) {
+    writeProfile();
+  }
+}
+
+void init::run() noexcept(false)
+{
+  PROFILE_SCOPE(profiler::krun);
+  if (shouldPrintNth) {
+    TIME_EXECUTION(clkVar,
+                   nthPrimeFound = Alg::nthPrime::find(&cinfo, sconfig,
+                                                       nthIndex));
+  }
+  else if (!cachePath.empty()) {
+    TIME_EXECUTION(clkVar,
+                   Alg::cachedSieve(&cinfo, &sconfig, cachePath,
+                                    arrLeftLim, arrRightLim,
+                                    listSink.get(), &numPrimes));
+  }
+  else if (sconfig.countOnly &&
+           sconfig.tuplets == Alg::tupletKind::none) {
+    TIME_EXECUTION(clkVar,
+                   numPrimes = Alg::primeCounter::count(&cinfo, sconfig,
+                                                        arrLeftLim,
+                                                        arrRightLim));
+  }
+  else {
+    TIME_EXECUTION(clkVar, 
+                   Alg::eratSieve<primeT>(&cinfo, &sconfig,
+                                          arrLeftLim, arrRightLim,
+                                          listSink.get(), &numPrimes));
+  }
 }
 
 init::~init()
@@ -48,7 +93,6 @@ init::~init()
 void init::destroy()
 {
   printOutput();
-  delete primesList;
 }
 
 void init::setMPIVariables()
@@ -57,33 +101,178 @@ void init::setMPIVariables()
   MPI_Comm_size(MPI_COMM_WORLD, &commSz);
 }
 
-void init::allocatePrimesList()
-{
-  primesList = new std::vector<primeT>;
-}
-
 void init::setAndValidateArguments(int argc, char** argv) 
   noexcept(false)
 {
-  if (argc != knumProgArgs) {
+  if (argc < knumProgArgs) {
     throw std::invalid_argument {
       "Wrong number of arguments.\n"\
         "Program usage:\n"\
-        "<program> <array-right-limit> (l | t | a)"};
+        "<program> <array-right-limit> (l | t | a | c)... "\
+        "| <program> <index> n [t] "\
+        "[--threads=<n>] [--left-limit=<m>] [--window-bytes=<b>] "\
+        "[--autotune=<w>] [--tune-file=<path>] "\
+        "[--format=(text | varint | bitmap)] [--output=<path>] "\
+        "[--counter=(auto | sieve | lmo)] [--cache=<path>] "\
+        "[--profile=<path>] [--schedule=(even | guided)] "\
+        "[--gather=(pipelined | round)] "\
+        "[--tuplets=(twins | cousins | triplets | quadruplets)] "\
+        "[--engine=(auto | <name>)]"};
   }
 
-  arrRightLim = atoi(argv[1]);
-  num<int>::checkInRange(arrRightLim, kminRightLim, kmaxRightLim);
+  outMode = argv[2];
+  const bool nthMode = outMode.find('n') != string::npos;
+  if (outMode.empty() ||
+      outMode.find_first_not_of(nthMode ? "nt" : "ltac")
+        != string::npos) {
+    throw std::invalid_argument {
+      string("Invalid output mode '") + argv[2] + '\''};
+  }
+
+  if (nthMode) {
+    // The range is the one the prime of that index is searched in.
+    nthIndex = num<uint64_t>::parseUnsigned(argv[1]);
+    num<uint64_t>::checkInRange(nthIndex, 1, Alg::nthPrime::kmaxIndex);
+    arrRightLim = Alg::nthPrime::getUpperBound(nthIndex);
+  }
+  else {
+    arrRightLim = num<primeT>::parseUnsigned(argv[1]);
+    num<primeT>::checkInRange(arrRightLim, kminRightLim,
+                              kmaxRightLim);
+  }
+
+  for (int i = knumProgArgs; i < argc; ++i) {
+    setOption(argv[i]);
+  }
+  num<primeT>::checkInRange(arrLeftLim, 0,
+                            nthMode ? 0 : arrRightLim);
+  if (nthMode && sconfig.tuplets != Alg::tupletKind::none) {
+    throw std::invalid_argument {
+      "--tuplets does not go along with n"};
+  }
+}
+
+void init::setOption(const char* arg) noexcept(false)
+{
+  const string option{arg};
+  const size_t eqPos = option.find('=');
+  if (eqPos == string::npos) {
+    throw std::invalid_argument {
+      string("Option '") + option + "' should be --<name>=<value>"};
+  }
+  const string name = option.substr(0, eqPos);
+  const char* value = arg + eqPos + 1;
 
-  outMode = argv[2][0];
-  switch(outMode) {
-    case 'l': // List
-    case 't': // Time
-    case 'a': // All
-      break;
-    default:
+  if (name == "--threads") {
+    sconfig.numThreads = num<unsigned>::parseUnsigned(value);
+    num<unsigned>::checkInRange(sconfig.numThreads, kminThreads,
+                                kmaxThreads);
+  }
+  else if (name == "--left-limit") {
+    arrLeftLim = num<primeT>::parseUnsigned(value);
+  }
+  else if (name == "--window-bytes") {
+    sconfig.windowBytes = num<size_t>::parseUnsigned(value);
+    num<size_t>::checkInRange(sconfig.windowBytes, kminWindowBytes,
+                              kmaxWindowBytes);
+  }
+  else if (name == "--autotune") {
+    autotuneSpan = num<primeT>::parseUnsigned(value);
+    num<primeT>::checkInRange(autotuneSpan, 1, kmaxRightLim);
+  }
+  else if (name == "--tune-file") {
+    tunePath = value;
+  }
+  else if (name == "--format") {
+    binaryOutput = string(value) != "text";
+    if (binaryOutput) {
+      outFormat = primeFile::parseFormat(value);
+    }
+  }
+  else if (name == "--output") {
+    outPath = value;
+  }
+  else if (name == "--counter") {
+    const string counter{value};
+    if (counter == "auto") {
+      sconfig.counter = Alg::countMethod::automatic;
+    }
+    else if (counter == "sieve") {
+      sconfig.counter = Alg::countMethod::sieve;
+    }
+    else if (counter == "lmo") {
+      sconfig.counter = Alg::countMethod::lmo;
+    }
+    else {
+      throw std::invalid_argument {
+        "Unknown counter '" + counter + '\''};
+    }
+  }
+  else if (name == "--cache") {
+    cachePath = value;
+  }
+  else if (name == "--profile") {
+    profilePath = value;
+  }
+  else if (name == "--schedule") {
+    const string schedule{value};
+    if (schedule == "even") {
+      sconfig.schedule = Alg::scheduleMode::even;
+    }
+    else if (schedule == "guided") {
+      sconfig.schedule = Alg::scheduleMode::guided;
+    }
+    else {
+      throw std::invalid_argument {
+        "Unknown schedule '" + schedule + '\''};
+    }
+  }
+  else if (name == "--gather") {
+    const string gather{value};
+    if (gather == "pipelined") {
+      sconfig.gather = Alg::gatherMode::pipelined;
+    }
+    else if (gather == "round") {
+      sconfig.gather = Alg::gatherMode::round;
+    }
+    else {
+      throw std::invalid_argument {
+        "Unknown gather '" + gather + '\''};
+    }
+  }
+  else if (name == "--tuplets") {
+    const string tuplets{value};
+    if (tuplets == "twins") {
+      sconfig.tuplets = Alg::tupletKind::twins;
+    }
+    else if (tuplets == "cousins") {
+      sconfig.tuplets = Alg::tupletKind::cousins;
+    }
+    else if (tuplets == "triplets") {
+      sconfig.tuplets = Alg::tupletKind::triplets;
+    }
+    else if (tuplets == "quadruplets") {
+      sconfig.tuplets = Alg::tupletKind::quadruplets;
+    }
+    else {
       throw std::invalid_argument {
-        string("Invalid output mode '") + argv[2] + '\''};
+        "Unknown tuplets '" + tuplets + '\''};
+    }
+  }
+  else if (name == "--engine") {
+    const string engine{value};
+    if (engine == "auto") {
+      sconfig.engine.clear();
+    }
+    else {
+      // Only to fail early on a name that is not there.
+      Alg::sieveEngine<primeT>::find(engine);
+      sconfig.engine = engine;
+    }
+  }
+  else {
+    throw std::invalid_argument {
+      string("Unknown option '") + name + '\''};
   }
 }
 
@@ -91,24 +280,148 @@ void init::processEntries(int argc, char** argv) noexcept(false)
 {
   Utils::hwInfo::fetchCacheInfo(&cinfo, LEVEL1, DATA_CACHE);
 
-  switch(outMode) {
-    case 'l': // List
-      shouldPrintList = true;
-      break;
-    case 't': // Time
-      shouldPrintTime = true;
-      break;
-    case 'a': // All
-      shouldPrintList = shouldPrintTime = true;
-      break;
+  for (const char mode : outMode) {
+    switch(mode) {
+      case 'l': // List
+        shouldPrintList = true;
+        break;
+      case 't': // Time
+        shouldPrintTime = true;
+        break;
+      case 'a': // All
+        shouldPrintList = shouldPrintTime = true;
+        break;
+      case 'c': // Count
+        shouldPrintCount = true;
+        break;
+      case 'n': // N-th prime
+        shouldPrintNth = true;
+        break;
+    }
+  }
+
+  sconfig.countOnly = shouldPrintCount && !shouldPrintList;
+  sconfig.rankLocalOutput = outPath.find("%r") != string::npos;
+  if (sconfig.rankLocalOutput && !cachePath.empty()) {
+    throw std::invalid_argument {
+      "--cache does not go along with an output path with %r"};
+  }
+  if (sconfig.tuplets != Alg::tupletKind::none && !cachePath.empty()) {
+    throw std::invalid_argument {
+      "--cache does not go along with --tuplets"};
+  }
+
+  if (autotuneSpan > 0) {
+    autotune();
+  }
+  else if (sconfig.windowBytes == 0) {
+    sconfig.windowBytes =
+      tuneFile::lookUp(tunePath, hwInfo::getHostName());
+  }
+
+  openOutput();
+}
+
+void init::openOutput() noexcept(false)
+{
+  // Unless each process writes its own file, the root gets all the
+  // primes.
+  if (!shouldPrintList ||
+      (!sconfig.rankLocalOutput && myProcRank != 0)) {
+    return;
+  }
+
+  string path = outPath;
+  const size_t rankPos = path.find("%r");
+  if (rankPos != string::npos) {
+    path.replace(rankPos, 2, to_string(myProcRank));
+  }
+  if (binaryOutput) {
+    if (!path.empty()) {
+      outFile.open(path, ios::binary | ios::trunc);
+      if (!outFile) {
+        throw std::runtime_error{"Could not open " + path};
+      }
+    }
+    outSink.reset(new binarySink(path.empty() ? cout : outFile,
+                                 outFormat));
+  }
+  else {
+    outSink.reset(new textSink(path, sconfig.numThreads));
+  }
+  listSink.reset(new Alg::asyncSink<primeT>(outSink.get()));
+}
+
+void init::autotune() noexcept(false)
+{
+  // A single process of each host does the timing, by itself, while
+  // the others wait. They would be fighting for the same caches
+  // otherwise.
+  MPI_Comm hostComm;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0,
+                      MPI_INFO_NULL, &hostComm);
+  int hostRank;
+  MPI_Comm_rank(hostComm, &hostRank);
+
+  uint64_t windowBytes = 0;
+  if (hostRank == 0) {
+    Alg::sieveConfig tuneConfig = sconfig;
+    tuneConfig.comm = MPI_COMM_SELF;
+    const primeT tuneLeftLim = arrRightLim -
+      num<primeT>::min(autotuneSpan - 1, arrRightLim - arrLeftLim);
+    windowBytes = Alg::segmentTuner::findBestWindowBytes(
+      &cinfo, tuneConfig, tuneLeftLim, arrRightLim);
+  }
+  MPI_Bcast(&windowBytes, 1, MPI_UINT64_T, 0, hostComm);
+  MPI_Comm_free(&hostComm);
+  sconfig.windowBytes = windowBytes;
+
+  // The root writes down the choice of every host.
+  char myHost[kmaxHostNameLen] = {};
+  strncpy(myHost, hwInfo::getHostName().c_str(), kmaxHostNameLen - 1);
+  vector<char> hosts(myProcRank == 0 ? commSz * kmaxHostNameLen : 0);
+  vector<uint64_t> hostWindowBytes(myProcRank == 0 ? commSz : 0);
+  MPI_Gather(myHost, kmaxHostNameLen, MPI_CHAR, hosts.data(),
+             kmaxHostNameLen, MPI_CHAR, 0, MPI_COMM_WORLD);
+  MPI_Gather(&windowBytes, 1, MPI_UINT64_T, hostWindowBytes.data(), 1,
+             MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+  if (myProcRank == 0) {
+    tuneFile::entriesT entries;
+    for (int i = 0; i < commSz; ++i) {
+      entries[&hosts[i * kmaxHostNameLen]] = hostWindowBytes[i];
+    }
+    tuneFile::update(tunePath, entries);
+  }
+}
+
+void init::writeProfile() noexcept(false)
+{
+  // Every process takes part in the report, before the root may
+  // fail to write it.
+  ostringstream report;
+  profiler::report(MPI_COMM_WORLD, report);
+  if (myProcRank != 0) {
+    return;
+  }
+
+  ofstream ofs(profilePath, ios::trunc);
+  ofs << report.str();
+  if (!ofs) {
+    throw std::runtime_error{"Could not write to " + profilePath};
   }
 }
 
 void init::printOutput()
 {
-  if (shouldPrintList) {
+  if (shouldPrintCount) {
     if (myProcRank == 0) {
-      printOutList();
+      printOutCount();
+    }
+  }
+  if (shouldPrintNth) {
+    if (myProcRank == 0) {
+      printOutNth();
     }
   }
   if (shouldPrintTime) {
@@ -116,20 +429,14 @@ void init::printOutput()
   }
 }
 
-void init::printOutList()
+void init::printOutCount()
 {
-  for (auto prime : *primesList) {
-#   if INTERFACE_INIT_DEBUG_PRINT_GREATER_THAN != 0
-    if (prime > INTERFACE_INIT_DEBUG_PRINT_GREATER_THAN) {
-#   endif
-
-    cout << prime << ' ';
+  cout << numPrimes << '\n';
+}
 
-#   if INTERFACE_INIT_DEBUG_PRINT_GREATER_THAN != 0
-    }
-#   endif
-  }
-  cout << '\n';
+void init::printOutNth()
+{
+  cout << nthPrimeFound << '\n';
 }
 
 void init::printOutTime()
@@ -0,0 +1,133 @@
+//===----------------------------------------------------------===//
+// Interface module
+//
+// File purpose: implementation of class ~library~. See header file
+// for more detail.
+//===----------------------------------------------------------===//
+
+#include "Interface/library.hpp"
+
+#include "Alg/cachedSieve.hpp"
+#include "Alg/nthPrime.hpp"
+#include "Alg/primeCounter.hpp"
+#include "Alg/vectorSink.hpp"
+#include "Utils/hwInfo.hpp"
+#include "Utils/num.hpp"
+
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace Utils;
+
+namespace Interface {
+
+constexpr primeT library::kmaxLimit;
+
+namespace {
+
+void finalizeMPI()
+{
+  int finalized = 0;
+  MPI_Finalized(&finalized);
+  if (!finalized) {
+    MPI_Finalize();
+  }
+}
+
+Alg::sieveConfig getSieveConfig(const libraryConfig& config,
+                                const bool countOnly)
+{
+  Alg::sieveConfig sconfig;
+  sconfig.numThreads = config.numThreads;
+  sconfig.countOnly = countOnly;
+  sconfig.windowBytes = config.windowBytes;
+  sconfig.counter = config.counter;
+  sconfig.schedule = config.schedule;
+  sconfig.gather = config.gather;
+  sconfig.engine = config.engine;
+  sconfig.comm = config.comm;
+  return sconfig;
+}
+
+}
+
+void library::generatePrimes(const primeT leftLim,
+                             const primeT rightLim,
+                             std::vector<primeT>* out,
+                             const libraryConfig& config)
+  noexcept(false)
+{
+  initMPI();
+  if (leftLim > rightLim) {
+    return;
+  }
+  num<primeT>::checkInRange(rightLim, 0, kmaxLimit);
+
+  cacheInfo cinfo;
+  hwInfo::fetchCacheInfo(&cinfo, LEVEL1, DATA_CACHE);
+  const Alg::sieveConfig sconfig = getSieveConfig(config, false);
+  Alg::vectorSink<primeT> sink(out);
+  std::uint64_t numPrimes = 0;
+  if (!config.cachePath.empty()) {
+    Alg::cachedSieve(&cinfo, &sconfig, config.cachePath, leftLim,
+                     rightLim, &sink, &numPrimes);
+    return;
+  }
+  Alg::eratSieve<primeT>(&cinfo, &sconfig, leftLim, rightLim, &sink,
+                         &numPrimes);
+}
+
+std::uint64_t library::countPrimes(const primeT leftLim,
+                                   const primeT rightLim,
+                                   const libraryConfig& config)
+  noexcept(false)
+{
+  initMPI();
+  if (leftLim > rightLim) {
+    return 0;
+  }
+  num<primeT>::checkInRange(rightLim, 0, kmaxLimit);
+
+  cacheInfo cinfo;
+  hwInfo::fetchCacheInfo(&cinfo, LEVEL1, DATA_CACHE);
+  const Alg::sieveConfig sconfig = getSieveConfig(config, true);
+  if (!config.cachePath.empty()) {
+    std::uint64_t numPrimes = 0;
+    Alg::cachedSieve(&cinfo, &sconfig, config.cachePath, leftLim,
+                     rightLim, nullptr, &numPrimes);
+    MPI_Bcast(&numPrimes, 1, MPI_UINT64_T, 0, config.comm);
+    return numPrimes;
+  }
+  return Alg::primeCounter::count(&cinfo, sconfig, leftLim, rightLim);
+}
+
+primeT library::nthPrime(const std::uint64_t n,
+                         const libraryConfig& config) noexcept(false)
+{
+  initMPI();
+
+  cacheInfo cinfo;
+  hwInfo::fetchCacheInfo(&cinfo, LEVEL1, DATA_CACHE);
+  const Alg::sieveConfig sconfig = getSieveConfig(config, true);
+  return Alg::nthPrime::find(&cinfo, sconfig, n);
+}
+
+void library::initMPI() noexcept(false)
+{
+  int initialized = 0;
+  MPI_Initialized(&initialized);
+  if (initialized) {
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (finalized) {
+      throw std::logic_error{"MPI was already finalized"};
+    }
+    return;
+  }
+
+  int provided;
+  MPI_Init_thread(nullptr, nullptr, MPI_THREAD_FUNNELED, &provided);
+  std::atexit(finalizeMPI);
+}
+
+}
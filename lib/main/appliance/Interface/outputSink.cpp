@@ -0,0 +1,76 @@
+//===----------------------------------------------------------===//
+// Interface module
+//
+// File purpose: implementation of the output sinks. See header file
+// for more detail.
+//===----------------------------------------------------------===//
+
+#include "Interface/outputSink.hpp"
+
+#include "Utils/defs.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+using namespace std;
+using namespace Utils;
+
+namespace Interface {
+
+textSink::textSink(const string& path, const unsigned numThreads)
+  noexcept(false)
+{
+  if (path.empty()) {
+    // Whatever went to cout so far has to come first.
+    cout.flush();
+    writer.reset(new decimalWriter(STDOUT_FILENO, numThreads));
+  }
+  else {
+    writer.reset(new decimalWriter(path, numThreads));
+  }
+}
+
+void textSink::start(const primeT, const primeT)
+{}
+
+void textSink::consume(vector<primeT>& primes) noexcept(false)
+{
+  const primeT* first = primes.data();
+  const primeT* const last = primes.data() + primes.size();
+# if INTERFACE_INIT_DEBUG_PRINT_GREATER_THAN != 0
+  first = upper_bound(first, last,
+                      static_cast<primeT>(
+                        INTERFACE_INIT_DEBUG_PRINT_GREATER_THAN));
+# endif
+  writer->append(first, last - first);
+}
+
+void textSink::finish() noexcept(false)
+{
+  writer->finish('\n');
+}
+
+binarySink::binarySink(ostream& os, const primeFile::format fmt)
+  : os(os), fmt(fmt)
+{}
+
+void binarySink::start(const primeT leftLim, const primeT rightLim)
+  noexcept(false)
+{
+  writer.reset(new primeFile::writer(os, fmt, leftLim, rightLim));
+}
+
+void binarySink::consume(vector<primeT>& primes) noexcept(false)
+{
+  writer->append(primes.data(), primes.size());
+}
+
+void binarySink::finish() noexcept(false)
+{
+  writer->finish();
+}
+
+}
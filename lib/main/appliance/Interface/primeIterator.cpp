@@ -0,0 +1,51 @@
+//===----------------------------------------------------------===//
+// Interface module
+//
+// File purpose: implementation of class ~primeIterator~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Interface/primeIterator.hpp"
+
+#include "Utils/num.hpp"
+
+#include <stdexcept>
+#include <string>
+
+using namespace Utils;
+
+namespace Interface {
+
+primeIterator::primeIterator(const primeT start,
+                             const libraryConfig& config)
+  noexcept(false)
+  : config(config), pos(0), chunkLeftLim(start),
+    chunkSpan(kminChunkSpan)
+{
+  this->config.comm = MPI_COMM_SELF;
+  nextChunk();
+}
+
+void primeIterator::nextChunk() noexcept(false)
+{
+  primes.clear();
+  pos = 0;
+  while (primes.empty()) {
+    if (chunkLeftLim > library::kmaxLimit) {
+      throw std::out_of_range{
+        "No primes left below " + std::to_string(library::kmaxLimit)};
+    }
+
+    const primeT span = num<primeT>::max(
+      chunkSpan, kchunkSqrtFactor * num<primeT>::isqrt(chunkLeftLim));
+    const primeT chunkRightLim = chunkLeftLim +
+      num<primeT>::min(span - 1, library::kmaxLimit - chunkLeftLim);
+    library::generatePrimes(chunkLeftLim, chunkRightLim, &primes,
+                            config);
+
+    chunkLeftLim = chunkRightLim + 1;
+    chunkSpan = num<primeT>::min(2 * chunkSpan, kmaxChunkSpan);
+  }
+}
+
+}
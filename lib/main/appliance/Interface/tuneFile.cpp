@@ -0,0 +1,88 @@
+//===----------------------------------------------------------===//
+// Interface module
+//
+// File purpose: implementation of class ~tuneFile~. See header file
+// for more detail.
+//===----------------------------------------------------------===//
+
+#include "Interface/tuneFile.hpp"
+
+#include "Utils/file.hpp"
+#include "Utils/num.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace Utils;
+
+namespace Interface {
+
+constexpr size_t tuneFile::kminWindowBytes;
+constexpr size_t tuneFile::kmaxWindowBytes;
+
+tuneFile::entriesT tuneFile::read(const string& path) noexcept(false)
+{
+  entriesT entries;
+  if (!file::exists(path.c_str())) {
+    return entries;
+  }
+
+  ifstream ifs(path);
+  string line;
+  for (unsigned lineNum = 1; getline(ifs, line); ++lineNum) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    istringstream fields(line);
+    string host, bytes, rest;
+    if (!(fields >> host >> bytes) || fields >> rest) {
+      throw std::logic_error{
+        path + ": line " + to_string(lineNum) +
+          ": expected '<host-name> <window-bytes>'"};
+    }
+    try {
+      const size_t windowBytes =
+        num<size_t>::parseUnsigned(bytes.c_str());
+      num<size_t>::checkInRange(windowBytes, kminWindowBytes,
+                                kmaxWindowBytes);
+      entries[host] = windowBytes;
+    }
+    catch (std::logic_error& e) {
+      throw std::logic_error{
+        path + ": line " + to_string(lineNum) + ": " + e.what()};
+    }
+  }
+
+  return entries;
+}
+
+size_t tuneFile::lookUp(const string& path, const string& host)
+  noexcept(false)
+{
+  const entriesT entries = read(path);
+  const auto entry = entries.find(host);
+  return entry == entries.end() ? 0 : entry->second;
+}
+
+void tuneFile::update(const string& path, const entriesT& entries)
+  noexcept(false)
+{
+  entriesT allEntries = read(path);
+  for (const auto& entry : entries) {
+    allEntries[entry.first] = entry.second;
+  }
+
+  ofstream ofs(path, ios::trunc);
+  ofs << "# eratosthenes-sieve window sizes, written by --autotune\n";
+  for (const auto& entry : allEntries) {
+    ofs << entry.first << ' ' << entry.second << '\n';
+  }
+  if (!ofs) {
+    throw std::runtime_error{"Could not write to " + path};
+  }
+}
+
+}
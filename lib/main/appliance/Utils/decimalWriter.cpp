@@ -0,0 +1,220 @@
+//===----------------------------------------------------------===//
+// Utils module
+//
+// File purpose: implementation of class ~decimalWriter~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Utils/decimalWriter.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace Utils {
+
+constexpr size_t decimalWriter::kmaxPrimeBytes;
+constexpr size_t decimalWriter::kbufferBytes;
+constexpr size_t decimalWriter::kbufferPrimes;
+constexpr size_t decimalWriter::kminParallelPrimes;
+
+namespace {
+
+const char kdigitPairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+const uint64_t kpowersOf10[20] = {
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+  10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+  100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+  100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+  100000000000000000ULL, 1000000000000000000ULL,
+  10000000000000000000ULL
+};
+
+// Number of digits of ~n~, which is not 0. The number of bits gives
+// log10(n) up to one: 1233 / 4096 is just below log10(2).
+inline unsigned countDigits(const uint64_t n)
+{
+  const unsigned bits = 64 - __builtin_clzll(n);
+  const unsigned guess = bits * 1233 >> 12;
+  return guess + (n >= kpowersOf10[guess]);
+}
+
+}
+
+decimalWriter::decimalWriter(const int fd, const unsigned numThreads)
+  noexcept(false)
+  : fd(fd), ownsFd(false), pool(numThreads), bufUsed(0)
+{
+  init();
+}
+
+decimalWriter::decimalWriter(const string& path,
+                             const unsigned numThreads) noexcept(false)
+  : fd(-1), ownsFd(true), pool(numThreads), bufUsed(0)
+{
+  fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    throw runtime_error{"Could not open " + path};
+  }
+  init();
+}
+
+decimalWriter::~decimalWriter()
+{
+  if (ownsFd && fd >= 0) {
+    close(fd);
+  }
+}
+
+void decimalWriter::init() noexcept(false)
+{
+  buf.reserve(kbufferBytes);
+  if (pool.size() > 1) {
+    parts.resize(pool.size());
+    for (DS::pageArena& part : parts) {
+      part.reserve(kbufferBytes);
+    }
+    partBytes.resize(pool.size());
+  }
+}
+
+char* decimalWriter::format(const uint64_t* primes, const size_t num,
+                            char* out)
+{
+  for (size_t i = 0; i < num; ++i) {
+    uint64_t n = primes[i];
+    const unsigned numDigits = countDigits(n);
+    char* digit = out + numDigits;
+    while (n >= 100) {
+      digit -= 2;
+      memcpy(digit, kdigitPairs + n % 100 * 2, 2);
+      n /= 100;
+    }
+    if (n >= 10) {
+      memcpy(digit - 2, kdigitPairs + n * 2, 2);
+    }
+    else {
+      digit[-1] = static_cast<char>('0' + n);
+    }
+    out[numDigits] = ' ';
+    out += numDigits + 1;
+  }
+  return out;
+}
+
+void decimalWriter::append(const uint64_t* primes, size_t num)
+  noexcept(false)
+{
+  if (pool.size() == 1 || num < kminParallelPrimes) {
+    while (num > 0) {
+      const size_t room = (kbufferBytes - bufUsed) / kmaxPrimeBytes;
+      if (room == 0) {
+        flush();
+        continue;
+      }
+      const size_t batch = min(num, room);
+      char* const bufBegin = static_cast<char*>(buf.data());
+      bufUsed = format(primes, batch, bufBegin + bufUsed) - bufBegin;
+      primes += batch;
+      num -= batch;
+    }
+    return;
+  }
+
+  // What came before has to go out first.
+  flush();
+
+  const size_t numParts = parts.size();
+  vector<const char*> partBegins(numParts);
+  for (size_t i = 0; i < numParts; ++i) {
+    partBegins[i] = static_cast<const char*>(parts[i].data());
+  }
+  while (num > 0) {
+    const size_t batch = min(num, kbufferPrimes * numParts);
+    pool.run(numParts, [&](const unsigned, const size_t part) {
+        const size_t first = batch * part / numParts;
+        const size_t last = batch * (part + 1) / numParts;
+        char* const partBegin = static_cast<char*>(parts[part].data());
+        partBytes[part] =
+          format(primes + first, last - first, partBegin) - partBegin;
+      });
+    writeAll(partBegins.data(), partBytes.data(), numParts);
+    primes += batch;
+    num -= batch;
+  }
+}
+
+void decimalWriter::finish(const char c) noexcept(false)
+{
+  if (bufUsed == kbufferBytes) {
+    flush();
+  }
+  static_cast<char*>(buf.data())[bufUsed++] = c;
+  flush();
+}
+
+void decimalWriter::flush() noexcept(false)
+{
+  const char* const bufBegin = static_cast<const char*>(buf.data());
+  writeAll(&bufBegin, &bufUsed, 1);
+  bufUsed = 0;
+}
+
+void decimalWriter::writeAll(const char* const* bufs,
+                             const size_t* sizes,
+                             const size_t numBufs) noexcept(false)
+{
+  // writev may stop anywhere, even in the middle of a buffer, so
+  // the vector is moved past whatever went out each time.
+  vector<iovec> iov;
+  for (size_t i = 0; i < numBufs; ++i) {
+    if (sizes[i] > 0) {
+      iov.push_back(iovec{const_cast<char*>(bufs[i]), sizes[i]});
+    }
+  }
+
+  size_t first = 0;
+  while (first < iov.size()) {
+    const int numIov = min<size_t>(iov.size() - first, IOV_MAX);
+    const ssize_t written = writev(fd, &iov[first], numIov);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw runtime_error{
+        string("Could not write the primes: ") + strerror(errno)};
+    }
+
+    size_t left = written;
+    while (left > 0 && left >= iov[first].iov_len) {
+      left -= iov[first].iov_len;
+      ++first;
+    }
+    if (left > 0) {
+      iov[first].iov_base = static_cast<char*>(iov[first].iov_base)
+        + left;
+      iov[first].iov_len -= left;
+    }
+  }
+}
+
+}
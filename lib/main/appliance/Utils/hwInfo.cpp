@@ -9,6 +9,9 @@
 #include "Utils/hwInfo.hpp"
 #include "Utils/num.hpp"
 
+#include <climits>
+#include <stdexcept>
+
 #include "unistd.h"
 
 namespace Utils {
@@ -64,5 +67,14 @@ void hwInfo::fetchCacheInfo(cacheInfo* const destStruct,
   destStruct->level = level;
 }
 
+std::string hwInfo::getHostName() noexcept(false)
+{
+  char name[HOST_NAME_MAX + 1] = {};
+  if (gethostname(name, HOST_NAME_MAX) != 0) {
+    throw std::runtime_error{"Could not get the host name"};
+  }
+  return name;
+}
+
 
 }
@@ -0,0 +1,263 @@
+//===----------------------------------------------------------===//
+// Utils module
+//
+// File purpose: implementation of class ~primeFile~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Utils/primeFile.hpp"
+
+#include "DS/wheelSegment.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace Utils {
+
+const char primeFile::kvarintMagic[4] = {'E', 'P', 'R', 'V'};
+const char primeFile::kbitmapMagic[4] = {'E', 'P', 'R', 'B'};
+
+namespace {
+
+// The host is little-endian (see DS::wheelSegment), so fields are
+// copied as they are.
+template <typename fieldType>
+void putField(vector<char>& buf, const fieldType field)
+{
+  const char* const bytes = reinterpret_cast<const char*>(&field);
+  buf.insert(buf.end(), bytes, bytes + sizeof(field));
+}
+
+template <typename fieldType>
+fieldType getField(const vector<char>& buf, const size_t pos)
+{
+  fieldType field;
+  memcpy(&field, &buf[pos], sizeof(field));
+  return field;
+}
+
+}
+
+namespace {
+
+// Number of wheel bytes of a bitmap of [leftLim, rightLim].
+uint64_t getBitmapBytes(const uint64_t leftLim, const uint64_t rightLim)
+{
+  const uint64_t base = leftLim - leftLim % DS::wheelSegment::kwheelSz;
+  return rightLim < base ? 0 :
+    (rightLim - base) / DS::wheelSegment::kwheelSz + 1;
+}
+
+// Bodies are written in chunks of about this size.
+constexpr size_t kwriteChunkSz = 1 << 20;
+
+}
+
+primeFile::writer::writer(ostream& os, const format fmt,
+                          const uint64_t leftLim,
+                          const uint64_t rightLim) noexcept(false)
+  : os(os), fmt(fmt), leftLim(leftLim), rightLim(rightLim),
+    headerPos(os.tellp()), numPrimes(0), prev(leftLim),
+    base(leftLim - leftLim % DS::wheelSegment::kwheelSz),
+    numBytes(getBitmapBytes(leftLim, rightLim)), numBytesDone(0),
+    curByte(0)
+{
+  const char* const magic =
+    fmt == format::varint ? kvarintMagic : kbitmapMagic;
+  buf.insert(buf.end(), magic, magic + 4);
+  putField<uint32_t>(buf, kversion);
+  putField<uint64_t>(buf, leftLim);
+  putField<uint64_t>(buf, rightLim);
+  putField<uint64_t>(buf, kunknownCount);
+  flushBuf();
+}
+
+void primeFile::writer::append(const uint64_t* primes, const size_t num)
+  noexcept(false)
+{
+  for (size_t i = 0; i < num; ++i) {
+    const uint64_t prime = primes[i];
+    if (fmt == format::varint) {
+      uint64_t gap = prime - prev;
+      for (; gap >= 0x80; gap >>= 7) {
+        buf.push_back(static_cast<char>(0x80 | (gap & 0x7F)));
+      }
+      buf.push_back(static_cast<char>(gap));
+      prev = prime;
+    }
+    else if (prime > 5) {
+      // Bytes before the one of ~prime~ are complete.
+      const size_t bit = DS::wheelSegment::offsetToBit(prime - base);
+      const uint64_t byteIdx = bit / DS::wheelSegment::knumResidues;
+      for (; numBytesDone < byteIdx; ++numBytesDone) {
+        buf.push_back(static_cast<char>(curByte));
+        curByte = 0;
+      }
+      curByte |= 1 << (bit % DS::wheelSegment::knumResidues);
+    }
+
+    if (buf.size() >= kwriteChunkSz) {
+      flushBuf();
+    }
+  }
+  numPrimes += num;
+}
+
+void primeFile::writer::finish() noexcept(false)
+{
+  if (fmt == format::bitmap) {
+    for (; numBytesDone < numBytes; ++numBytesDone) {
+      buf.push_back(static_cast<char>(curByte));
+      curByte = 0;
+      if (buf.size() >= kwriteChunkSz) {
+        flushBuf();
+      }
+    }
+  }
+  flushBuf();
+
+  if (headerPos != -1) {
+    const streamoff endPos = os.tellp();
+    os.seekp(headerPos + kheaderSz - sizeof(numPrimes));
+    putField<uint64_t>(buf, numPrimes);
+    flushBuf();
+    os.seekp(endPos);
+  }
+  os.flush();
+}
+
+void primeFile::writer::flushBuf() noexcept(false)
+{
+  os.write(buf.data(), buf.size());
+  buf.clear();
+  if (!os) {
+    throw std::runtime_error{"Could not write the primes"};
+  }
+}
+
+void primeFile::write(ostream& os, const format fmt,
+                      const uint64_t leftLim, const uint64_t rightLim,
+                      const vector<uint64_t>& primes) noexcept(false)
+{
+  writer w(os, fmt, leftLim, rightLim);
+  w.append(primes.data(), primes.size());
+  w.finish();
+}
+
+vector<uint64_t> primeFile::read(const string& path, header* hdr)
+  noexcept(false)
+{
+  ifstream ifs(path, ios::binary | ios::ate);
+  if (!ifs) {
+    throw std::runtime_error{"Could not open " + path};
+  }
+  vector<char> buf(ifs.tellg());
+  ifs.seekg(0);
+  ifs.read(buf.data(), buf.size());
+  if (!ifs || buf.size() < kheaderSz) {
+    throw std::runtime_error{path + ": not a prime file"};
+  }
+
+  header h;
+  if (memcmp(buf.data(), kvarintMagic, 4) == 0) {
+    h.fmt = format::varint;
+  }
+  else if (memcmp(buf.data(), kbitmapMagic, 4) == 0) {
+    h.fmt = format::bitmap;
+  }
+  else {
+    throw std::runtime_error{path + ": not a prime file"};
+  }
+  if (getField<uint32_t>(buf, 4) != kversion) {
+    throw std::runtime_error{path + ": unknown version " +
+        to_string(getField<uint32_t>(buf, 4))};
+  }
+  h.leftLim = getField<uint64_t>(buf, 8);
+  h.rightLim = getField<uint64_t>(buf, 16);
+  h.numPrimes = getField<uint64_t>(buf, 24);
+
+  // A varint takes at least a byte, and a wheel byte holds at most
+  // 8 primes, besides 2, 3 and 5. A count past that is not to be
+  // trusted with the room for the primes.
+  const uint64_t bodySz = buf.size() - kheaderSz;
+  const uint64_t maxPrimes =
+    h.fmt == format::varint ? bodySz :
+      bodySz * DS::wheelSegment::knumResidues + 3;
+  vector<uint64_t> primes;
+  if (h.numPrimes != kunknownCount) {
+    if (h.numPrimes > maxPrimes) {
+      throw std::runtime_error{
+        path + ": header says " + to_string(h.numPrimes) +
+          " primes, the body holds at most " + to_string(maxPrimes)};
+    }
+    primes.reserve(h.numPrimes);
+  }
+  if (h.fmt == format::varint) {
+    uint64_t prev = h.leftLim;
+    for (size_t pos = kheaderSz; pos < buf.size();) {
+      uint64_t gap = 0;
+      unsigned shift = 0;
+      uint8_t byte;
+      do {
+        if (pos == buf.size() || shift > 63) {
+          throw std::runtime_error{path + ": truncated varint"};
+        }
+        byte = buf[pos++];
+        gap |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        shift += 7;
+      } while (byte & 0x80);
+      prev += gap;
+      primes.push_back(prev);
+    }
+  }
+  else {
+    for (const uint64_t wheelPrime : {2, 3, 5}) {
+      if (wheelPrime >= h.leftLim && wheelPrime <= h.rightLim) {
+        primes.push_back(wheelPrime);
+      }
+    }
+    const uint64_t base =
+      h.leftLim - h.leftLim % DS::wheelSegment::kwheelSz;
+    if (buf.size() - kheaderSz != getBitmapBytes(h.leftLim, h.rightLim)) {
+      throw std::runtime_error{path + ": wrong bitmap size"};
+    }
+    for (size_t pos = kheaderSz; pos < buf.size(); ++pos) {
+      for (unsigned bits = static_cast<uint8_t>(buf[pos]); bits != 0;
+           bits &= bits - 1) {
+        primes.push_back(base + DS::wheelSegment::bitToOffset(
+          (pos - kheaderSz) * DS::wheelSegment::knumResidues
+          + __builtin_ctz(bits)));
+      }
+    }
+  }
+
+  if (h.numPrimes == kunknownCount) {
+    h.numPrimes = primes.size();
+  }
+  else if (primes.size() != h.numPrimes) {
+    throw std::runtime_error{
+      path + ": header says " + to_string(h.numPrimes) +
+        " primes, found " + to_string(primes.size())};
+  }
+  if (hdr) {
+    *hdr = h;
+  }
+  return primes;
+}
+
+primeFile::format primeFile::parseFormat(const string& name)
+  noexcept(false)
+{
+  if (name == "varint") {
+    return format::varint;
+  }
+  if (name == "bitmap") {
+    return format::bitmap;
+  }
+  throw std::invalid_argument{"Unknown format '" + name + '\''};
+}
+
+}
@@ -0,0 +1,189 @@
+//===----------------------------------------------------------===//
+// Utils module
+//
+// File purpose: implementation of class ~profiler~. See header file
+// for more detail.
+//===----------------------------------------------------------===//
+
+#include "Utils/profiler.hpp"
+
+#include <cstring>
+#include <iomanip>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace Utils {
+
+bool profiler::enabled = false;
+int profiler::counterFd = -1;
+profiler::phaseTotals profiler::totals[knumPhases];
+
+const char* const profiler::kphaseNames[knumPhases] = {
+  "run", "firstPass", "findSievingPrimes", "shareSievingPrimes",
+  "markPrimesLocal", "fuseCurPrimesGlobal", "output"
+};
+
+const char* const profiler::kcounterNames[knumCounters] = {
+  "cycles", "l1dMisses", "branchMisses"
+};
+
+profiler::scope::scope(const phase p)
+  : p(p)
+{
+  if (!enabled) {
+    return;
+  }
+  readCounters(startCounters);
+  start = chrono::steady_clock::now();
+}
+
+profiler::scope::~scope()
+{
+  if (!enabled) {
+    return;
+  }
+  const auto end = chrono::steady_clock::now();
+  uint64_t endCounters[knumCounters];
+  readCounters(endCounters);
+
+  phaseTotals& t = totals[p];
+  t.seconds += chrono::duration<double>(end - start).count();
+  ++t.calls;
+  for (unsigned i = 0; i < knumCounters; ++i) {
+    t.counters[i] += endCounters[i] - startCounters[i];
+  }
+}
+
+void profiler::enable(const bool withCounters)
+{
+  if (withCounters && counterFd < 0) {
+    openCounters();
+  }
+  enabled = true;
+}
+
+void profiler::openCounters()
+{
+#ifdef __linux__
+  const uint64_t configs[knumCounters][2] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+       | PERF_COUNT_HW_CACHE_OP_READ << 8
+       | PERF_COUNT_HW_CACHE_RESULT_MISS << 16},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+  };
+
+  // The counters are read all at once, through the first one. Kernel
+  // code is left out, which most systems allow without privileges.
+  int fds[knumCounters];
+  for (unsigned i = 0; i < knumCounters; ++i) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = configs[i][0];
+    attr.config = configs[i][1];
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fds[i] = syscall(__NR_perf_event_open, &attr, 0, -1,
+                     i == 0 ? -1 : fds[0], 0);
+    if (fds[i] < 0) {
+      for (unsigned j = 0; j < i; ++j) {
+        close(fds[j]);
+      }
+      return;
+    }
+  }
+  counterFd = fds[0];
+#endif
+}
+
+void profiler::readCounters(uint64_t* values)
+{
+#ifdef __linux__
+  // Number of counters, then their values.
+  uint64_t group[1 + knumCounters];
+  if (counterFd >= 0 &&
+      read(counterFd, group, sizeof(group)) ==
+        static_cast<ssize_t>(sizeof(group))) {
+    memcpy(values, group + 1, sizeof(uint64_t) * knumCounters);
+    return;
+  }
+#endif
+  memset(values, 0, sizeof(uint64_t) * knumCounters);
+}
+
+void profiler::report(MPI_Comm comm, ostream& out)
+{
+  int myProcRank;
+  int commSz;
+  MPI_Comm_rank(comm, &myProcRank);
+  MPI_Comm_size(comm, &commSz);
+
+  // The counters are only shown if every process has them.
+  int myHasCounters = counterFd >= 0;
+  int hasCounters = 0;
+  MPI_Allreduce(&myHasCounters, &hasCounters, 1, MPI_INT, MPI_MIN,
+                comm);
+
+  // Seconds, calls and counters of each phase, one after the other.
+  const unsigned kvaluesPerPhase = 2 + knumCounters;
+  vector<double> mine(knumPhases * kvaluesPerPhase);
+  for (unsigned p = 0; p < knumPhases; ++p) {
+    double* values = &mine[p * kvaluesPerPhase];
+    values[0] = totals[p].seconds;
+    values[1] = totals[p].calls;
+    for (unsigned i = 0; i < knumCounters; ++i) {
+      values[2 + i] = totals[p].counters[i];
+    }
+  }
+
+  vector<double> mins(mine.size());
+  vector<double> sums(mine.size());
+  vector<double> maxs(mine.size());
+  MPI_Reduce(mine.data(), mins.data(), mine.size(), MPI_DOUBLE,
+             MPI_MIN, 0, comm);
+  MPI_Reduce(mine.data(), sums.data(), mine.size(), MPI_DOUBLE,
+             MPI_SUM, 0, comm);
+  MPI_Reduce(mine.data(), maxs.data(), mine.size(), MPI_DOUBLE,
+             MPI_MAX, 0, comm);
+  if (myProcRank != 0) {
+    return;
+  }
+
+  const auto writeStats = [&](const char* name, const unsigned idx) {
+    out << "\"" << name << "\": {\"min\": " << mins[idx]
+        << ", \"avg\": " << sums[idx] / commSz
+        << ", \"max\": " << maxs[idx] << "}";
+  };
+
+  out << setprecision(9) << "{\n"
+      << "  \"processes\": " << commSz << ",\n"
+      << "  \"counters\": " << (hasCounters ? "true" : "false") << ",\n"
+      << "  \"phases\": {";
+  for (unsigned p = 0; p < knumPhases; ++p) {
+    const unsigned first = p * kvaluesPerPhase;
+    out << (p > 0 ? "," : "") << "\n    \"" << kphaseNames[p]
+        << "\": {\n      ";
+    writeStats("seconds", first);
+    out << ",\n      ";
+    writeStats("calls", first + 1);
+    if (hasCounters) {
+      for (unsigned i = 0; i < knumCounters; ++i) {
+        out << ",\n      ";
+        writeStats(kcounterNames[i], first + 2 + i);
+      }
+    }
+    out << "\n    }";
+  }
+  out << "\n  }\n}\n";
+}
+
+}
@@ -0,0 +1,152 @@
+//===----------------------------------------------------------===//
+// Utils module
+//
+// File purpose: implementation of class ~threadPool~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Utils/threadPool.hpp"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace Utils {
+
+threadPool::threadPool(const unsigned numThreads)
+  : curTask(nullptr), generation(0), numWorking(0), stopping(false)
+{
+  if (numThreads == 0) {
+    throw invalid_argument{"threadPool needs at least one thread"};
+  }
+
+  for (unsigned i = 0; i < numThreads; ++i) {
+    queues.emplace_back(new workQueue{});
+  }
+  for (unsigned i = 1; i < numThreads; ++i) {
+    workers.emplace_back(&threadPool::workerLoop, this, i);
+  }
+}
+
+threadPool::~threadPool()
+{
+  {
+    lock_guard<mutex> lock(poolMtx);
+    stopping = true;
+  }
+  startCv.notify_all();
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+void threadPool::runTasks(const size_t numTasks, const taskT& task)
+  noexcept(false)
+{
+  if (numTasks == 0) {
+    return;
+  }
+
+  // Workers are all asleep at this point, so the queues can be
+  // filled without any contention.
+  const size_t numThreads = queues.size();
+  for (size_t t = 0; t < numThreads; ++t) {
+    queues[t]->first = t * numTasks / numThreads;
+    queues[t]->last = (t + 1) * numTasks / numThreads;
+  }
+
+  {
+    lock_guard<mutex> lock(poolMtx);
+    curTask = &task;
+    firstError = nullptr;
+    numWorking = workers.size();
+    ++generation;
+  }
+  startCv.notify_all();
+
+  work(0);
+
+  exception_ptr error;
+  {
+    unique_lock<mutex> lock(poolMtx);
+    doneCv.wait(lock, [this] { return numWorking == 0; });
+    curTask = nullptr;
+    error = firstError;
+  }
+  if (error) {
+    rethrow_exception(error);
+  }
+}
+
+void threadPool::workerLoop(const unsigned threadIdx)
+{
+  unsigned long seenGeneration = 0;
+  for (;;) {
+    {
+      unique_lock<mutex> lock(poolMtx);
+      startCv.wait(lock, [this, seenGeneration] {
+          return stopping || generation != seenGeneration;
+        });
+      if (stopping) {
+        return;
+      }
+      seenGeneration = generation;
+    }
+
+    work(threadIdx);
+
+    {
+      lock_guard<mutex> lock(poolMtx);
+      if (--numWorking == 0) {
+        doneCv.notify_one();
+      }
+    }
+  }
+}
+
+void threadPool::work(const unsigned threadIdx)
+{
+  size_t taskIdx = 0;
+  while (nextTask(threadIdx, taskIdx)) {
+    try {
+      (*curTask)(threadIdx, taskIdx);
+    }
+    catch (...) {
+      lock_guard<mutex> lock(poolMtx);
+      if (!firstError) {
+        firstError = current_exception();
+      }
+    }
+  }
+}
+
+bool threadPool::nextTask(const unsigned threadIdx, size_t& taskIdx)
+{
+  // Own queue first, from the front, to keep walking contiguous
+  // tasks.
+  {
+    workQueue& own = *queues[threadIdx];
+    lock_guard<mutex> lock(own.mtx);
+    if (own.first < own.last) {
+      taskIdx = own.first++;
+      return true;
+    }
+  }
+
+  // Then steal from the back of the others.
+  const size_t numThreads = queues.size();
+  for (size_t i = 1; i < numThreads; ++i) {
+    workQueue& victim = *queues[(threadIdx + i) % numThreads];
+    lock_guard<mutex> lock(victim.mtx);
+    if (victim.first < victim.last) {
+      taskIdx = --victim.last;
+      return true;
+    }
+  }
+
+  // No task is ever added during a batch, so we are done.
+  return false;
+}
+
+}
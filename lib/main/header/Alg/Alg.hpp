@@ -8,6 +8,19 @@
 #ifndef ALG_H
 #define ALG_H
 
+#include "Alg/asyncSink.hpp"
+#include "Alg/atkinProducer.hpp"
+#include "Alg/cachedSieve.hpp"
+#include "Alg/eratProducer.hpp"
 #include "Alg/eratSieve.hpp"
+#include "Alg/lmoCounter.hpp"
+#include "Alg/nthPrime.hpp"
+#include "Alg/primeCounter.hpp"
+#include "Alg/primeSink.hpp"
+#include "Alg/segmentProducer.hpp"
+#include "Alg/segmentTuner.hpp"
+#include "Alg/sieveConfig.hpp"
+#include "Alg/sieveEngine.hpp"
+#include "Alg/vectorSink.hpp"
 
 #endif
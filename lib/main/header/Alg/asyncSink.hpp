@@ -0,0 +1,146 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: ~asyncSink~ class declaration and definition.
+//
+// Description: a sink that passes the primes on to another sink, in
+// a thread of its own. The sieve can then go on with the next chunk
+// while the previous ones are being written. At most kmaxPending
+// chunks wait in between, so memory stays bounded even if writing
+// is slower than sieving. Each of them waits in a slot of its own,
+// and the buffer a slot held before goes back to the sieve in
+// exchange, so once the slots are warm no chunk costs an allocation.
+//===----------------------------------------------------------===//
+
+#ifndef ASYNCSINK_H
+#define ASYNCSINK_H
+
+#include "Alg/primeSink.hpp"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Alg {
+
+template <typename primeType>
+class asyncSink : public primeSink<primeType> {
+public:
+  // Chunks received, and not written yet, before consume blocks.
+  static constexpr unsigned kmaxPending = 2;
+
+  explicit asyncSink(primeSink<primeType>* inner)
+    : inner(inner), firstPending(0), numPending(0), finishing(false)
+  {}
+
+  ~asyncSink() override
+  {
+    stopWriter();
+  }
+
+  void start(const primeType leftLim, const primeType rightLim)
+    noexcept(false) override
+  {
+    inner->start(leftLim, rightLim);
+    writer = std::thread(&asyncSink::writerLoop, this);
+  }
+
+  void consume(std::vector<primeType>& primes) noexcept(false) override
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [this] {
+        return numPending < kmaxPending || error;
+      });
+    rethrowError();
+    std::vector<primeType>& slot =
+      pending[(firstPending + numPending) % kmaxPending];
+    slot.swap(primes);
+    primes.clear();
+    primes.reserve(slot.capacity());
+    ++numPending;
+    cv.notify_all();
+  }
+
+  void finish() noexcept(false) override
+  {
+    stopWriter();
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      rethrowError();
+    }
+    inner->finish();
+  }
+
+private:
+  primeSink<primeType>* inner;
+  std::thread writer;
+
+  // Everything below is protected by mtx.
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::vector<primeType> pending[kmaxPending];
+  unsigned firstPending;
+  unsigned numPending;
+  bool finishing;
+  std::exception_ptr error;
+
+  void writerLoop()
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    for (;;) {
+      cv.wait(lock, [this] { return numPending > 0 || finishing; });
+      if (numPending == 0) {
+        return;
+      }
+
+      // The chunk stays in the queue while it is written, so that it
+      // still counts against kmaxPending.
+      std::vector<primeType>& primes = pending[firstPending];
+      lock.unlock();
+      try {
+        inner->consume(primes);
+      }
+      catch (...) {
+        lock.lock();
+        error = std::current_exception();
+        numPending = 0;
+        cv.notify_all();
+        return;
+      }
+      lock.lock();
+      firstPending = (firstPending + 1) % kmaxPending;
+      --numPending;
+      cv.notify_all();
+    }
+  }
+
+  // Waits for every pending chunk to be written.
+  void stopWriter()
+  {
+    if (!writer.joinable()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      finishing = true;
+    }
+    cv.notify_all();
+    writer.join();
+  }
+
+  void rethrowError() noexcept(false)
+  {
+    if (error) {
+      std::exception_ptr e = error;
+      error = nullptr;
+      std::rethrow_exception(e);
+    }
+  }
+};
+
+}
+
+#endif
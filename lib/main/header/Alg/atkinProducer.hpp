@@ -0,0 +1,67 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: ~atkinProducer~ class declaration.
+//
+// Description: the segmented sieve of Atkin and Bernstein. A
+// squarefree n coprime to 60 is prime if and only if it has an odd
+// number of representations
+//
+//   4x^2 + y^2 = n,        x, y > 0,      n mod 60 in {1, 13, 17,
+//                                          29, 37, 41, 49, 53}
+//   3x^2 + y^2 = n,        x, y > 0,      n mod 60 in {7, 19, 31, 43}
+//   3x^2 - y^2 = n,        x > y > 0,     n mod 60 in {11, 23, 47, 59}
+//
+// so each window starts with the bits of the solutions of the forms
+// flipped, and the multiples of the squares of the sieving primes
+// are then marked. It walks every x whose solutions may fall in the
+// window, so a window costs on the order of the square root of its
+// right limit on top of its span.
+//===----------------------------------------------------------===//
+
+#ifndef ATKINPRODUCER_H
+#define ATKINPRODUCER_H
+
+#include "Alg/segmentProducer.hpp"
+#include "DS/wheelSegment.hpp"
+
+#include <cstddef>
+
+namespace Alg {
+
+template <typename primeType>
+class atkinProducer : public segmentProducer<primeType> {
+public:
+  atkinProducer();
+
+  void start(const primeType* sievingPrimes,
+             const std::size_t numSievingPrimes) noexcept(false) override;
+  void produce(DS::wheelSegment& segment, const primeType leftLim,
+               const primeType rightLim) noexcept(false) override;
+
+private:
+  static constexpr unsigned kformsMod = 60;
+
+  const primeType* sievingPrimes;
+  std::size_t numSievingPrimes;
+
+  // Flips the bits of the solutions of a*x^2 + y^2 in [leftLim,
+  // rightLim), with x and y stepping from their first values by 2
+  // or by 1, whose form is ~form~.
+  static void flipSum(DS::wheelSegment& segment,
+                      const primeType leftLim, const primeType rightLim,
+                      const unsigned a, const primeType firstX,
+                      const primeType stepX, const primeType firstY,
+                      const unsigned form);
+  // The same for 3x^2 - y^2, with x > y.
+  static void flipDifference(DS::wheelSegment& segment,
+                             const primeType leftLim,
+                             const primeType rightLim);
+
+  // Smallest r such that r * r >= n.
+  static primeType ceilSqrt(const primeType n);
+};
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: declaration of class ~cachedSieve~.
+//
+// Description: eratSieve in front of a DS::primeCache. The blocks of
+// the range that are in the cache are read from it, and only the
+// runs of blocks missing from it are sieved, by eratSieve, and
+// stored in it on the way. Counting whole blocks that are cached
+// only takes their counts, so repeated or overlapping queries mostly
+// come down to reading the page cache.
+//
+// Only the root process maps the cache. The others take part in
+// sieving what is missing.
+//===----------------------------------------------------------===//
+
+#ifndef CACHEDSIEVE_H
+#define CACHEDSIEVE_H
+
+#include "Alg/eratSieve.hpp"
+#include "Alg/primeSink.hpp"
+#include "Alg/sieveConfig.hpp"
+#include "DS/primeCache.hpp"
+#include "Utils/hwInfo.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Alg {
+
+class cachedSieve {
+public:
+  // Same as eratSieve, with the cache at ~cachePath~ (created if
+  // needed). Numbers past DS::primeCache::limit() are sieved as
+  // usual. config->rankLocalOutput is not supported.
+  cachedSieve(const Utils::cacheInfo*, const sieveConfig*,
+              const std::string& cachePath, const primeT userLeftLim,
+              const primeT userRightLim, primeSink<primeT>* sink,
+              std::uint64_t* numPrimes) noexcept(false);
+
+private:
+  // Primes handed to the sink at once, when read from the cache.
+  static constexpr std::size_t kchunkPrimes = 1 << 20;
+
+  const Utils::cacheInfo* cinfo;
+  const sieveConfig* config;
+  const primeT userLeftLim;
+  const primeT userRightLim;
+
+  int myProcRank;
+  // Null in count mode, and in every process but the root.
+  primeSink<primeT>* sink;
+  // Root process only.
+  std::unique_ptr<DS::primeCache> cache;
+  std::uint64_t numPrimesFound;
+
+  void addSmallPrimes() noexcept(false);
+  // Runs of consecutive blocks in [firstBlock, lastBlock] missing
+  // from the cache, as pairs of first and last block. Every process
+  // gets them.
+  std::vector<std::uint64_t> findGaps(const std::uint64_t firstBlock,
+                                      const std::uint64_t lastBlock)
+    noexcept(false);
+  void sieveGap(const std::uint64_t firstBlock,
+                const std::uint64_t lastBlock) noexcept(false);
+  // Root only. Reads the primes of [leftLim, rightLim] off the
+  // cache, where every block is present.
+  void readCached(const primeT leftLim, const primeT rightLim)
+    noexcept(false);
+  void sieveUncached(const primeT leftLim) noexcept(false);
+};
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: ~eratProducer~ class declaration.
+//
+// Description: the segmented sieve of Eratosthenes over the wheel of
+// 30. The multiples of the smallest primes come from the presieve
+// pattern, the ones of the primes smaller than a window are marked
+// window by window, and the larger primes wait in buckets for the
+// windows they hit. See DS::wheelSegment and DS::wheelBuckets.
+//===----------------------------------------------------------===//
+
+#ifndef ERATPRODUCER_H
+#define ERATPRODUCER_H
+
+#include "Alg/segmentProducer.hpp"
+#include "DS/wheelBuckets.hpp"
+#include "DS/wheelSegment.hpp"
+
+#include <cstddef>
+
+namespace Alg {
+
+template <typename primeType>
+class eratProducer : public segmentProducer<primeType> {
+public:
+  // For windows of ~windowBytes~ bytes.
+  explicit eratProducer(const std::size_t windowBytes);
+
+  void start(const primeType* sievingPrimes,
+             const std::size_t numSievingPrimes) noexcept(false) override;
+  void produce(DS::wheelSegment& segment, const primeType leftLim,
+               const primeType rightLim) noexcept(false) override;
+
+  // Marks the multiples of the sieving primes that are marked window
+  // by window, the part of produce between the presieve and the
+  // buckets.
+  void markSmallPrimes(DS::wheelSegment& segment,
+                       const primeType leftLim,
+                       const primeType rightLim) const;
+
+private:
+  const std::size_t windowBytes;
+
+  const primeType* sievingPrimes;
+  std::size_t numSievingPrimes;
+  // Sieving primes below numPresievedPrimes come marked by the
+  // presieve pattern. The ones up to numSmallSievingPrimes are marked
+  // window by window, and the larger ones go through the buckets.
+  std::size_t numPresievedPrimes;
+  std::size_t numSmallSievingPrimes;
+
+  // Sieving primes larger than a window, waiting for the window that
+  // holds their next multiple. Only useful while the windows come
+  // one after the other.
+  DS::wheelBuckets<primeType> buckets;
+};
+
+}
+
+#endif
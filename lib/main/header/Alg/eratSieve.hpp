@@ -10,149 +10,409 @@
 #ifndef ERATSIEVE_H
 #define ERATSIEVE_H
 
-#include "Alg/eratSieve.hpp"
+#include "Alg/hostPrimeList.hpp"
+#include "Alg/primeSink.hpp"
+#include "Alg/segmentProducer.hpp"
+#include "Alg/sieveConfig.hpp"
+#include "DS/primeBounds.hpp"
+#include "DS/tupletPattern.hpp"
+#include "DS/wheelSegment.hpp"
 #include "Utils/error.hpp"
 #include "Utils/hwInfo.hpp"
 #include "Utils/num.hpp"
+#include "Utils/threadPool.hpp"
 
-
-#include <boost/dynamic_bitset.hpp>
-
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <vector>
 
-#define SQRD(n) (n > 65535 ? 4294967295 : (n) * (n))
-
+#include "mpi.h"
 
-typedef unsigned primeT;
+// Type used to represent primes throughout the program.
+typedef std::uint64_t primeT;
 
 namespace Alg {
 
+template <typename primeType>
 class eratSieve {
 public:
-  eratSieve(const Utils::cacheInfo*, const unsigned userRightLim,
-            std::vector<primeT>* curPrimes);
+  // Finds the primes in [userLeftLim, userRightLim].
+  //
+  // With config->schedule set to guided, the processes do not get a
+  // slab each. They claim chunks of the range off a shared counter
+  // instead, the first ones wide and the last ones narrow, so that
+  // the slower processes simply claim fewer of them. When listing,
+  // the chunks are sent to the root, which hands them to the sink in
+  // order.
+  //
+  // With an even schedule and config->gather set to pipelined, the
+  // other processes send their primes to the root a batch of
+  // segments at a time, as soon as each one is sieved, and the root
+  // takes them in while it sieves its own slab.
+  //
+  // ~sink~ receives all of them, in order, chunk by chunk, in the
+  // root process. With config->rankLocalOutput, each process gets
+  // the primes of its own slab of the range instead. The sink is not
+  // used if config->countOnly is set, and may be null then. In every
+  // case, the root process gets the number of primes in
+  // ~numPrimes~.
+  //
+  // The windows are sieved by the engine named by config->engine,
+  // or by the one sieveEngine picks for the range. Everything else
+  // is the same whatever the engine.
+  //
+  // With config->tuplets set, the same goes for the tuplets of that
+  // kind whose numbers all lie in [userLeftLim, userRightLim], each
+  // one given by its first prime, instead of the primes. They are
+  // found right in the windows, and never go through a list of
+  // primes.
+  eratSieve(const Utils::cacheInfo*, const sieveConfig*,
+            const primeType userLeftLim, const primeType userRightLim,
+            primeSink<primeType>* sink, std::uint64_t* numPrimes);
   ~eratSieve();
 
 private:
   // Input constants
   const Utils::cacheInfo* cinfo;
-  const unsigned userRightLim;
+  const sieveConfig* config;
+  // Smallest and largest numbers that have to be checked
+  // (inclusive).
+  const primeType userLeftLim;
+  const primeType userRightLim;
+  // Largest prime that may be needed to sieve up to userRightLim.
+  const primeType maxSievingPrime;
 
   // MPI variables
   int myProcRank;
   int commSz;
-  unsigned interProcBusWidth;
+  // Gather of the primes of the last round into the root process,
+  // and the number of primes of each process in it, which have to
+  // outlive the request. See fuseCurPrimesGlobal.
+  MPI_Request fuseRequest;
+  std::vector<std::uint64_t> fuseSizes;
+  std::vector<int> fuseCounts;
+  std::vector<int> fuseDispls;
 
 
   //===--------------------------------------------------------===//
   // Aux. procedures
   //===--------------------------------------------------------===//
+  // Half of the L1 data cache, unless config says otherwise.
+  inline std::size_t getWindowBytes() const
+  {
+    if (config->windowBytes > 0) {
+      return config->windowBytes;
+    }
+    return cinfo->size > 0 ? cinfo->size / 2 : kdefaultWindowBytes;
+  }
+
   void initMPIVariables();
-  void initCurPrimes();
+  void initBuffers();
   void destroy();
 
+  // Most primes there may be in ~span~ numbers from roundLeftLim on,
+  // i.e. the room a buffer of them needs so as to never grow.
+  inline std::size_t getMaxRoundPrimes(const primeType span) const
+  {
+    return Utils::num<std::uint64_t>::min(
+      DS::primeBounds::maxPrimesInSpan(span),
+      DS::primeBounds::maxPrimesBetween(
+        roundLeftLim, static_cast<std::uint64_t>(userRightLim) + 1));
+  }
+
   //===--------------------------------------------------------===//
   // Objects used by the algorithm.
   //===--------------------------------------------------------===//
 
-  // Numbers currently marked as primes. Allocated according to size
-  // of the cache line.
-  //
-  // This bitset is updated all the time.
-  boost::dynamic_bitset<> markWindow;
-  // Current list of primes.
-  std::vector<primeT>* curPrimes;
+  // 2, 3 and 5 are the primes of the wheel. They never get marked
+  // in markWindow, and always come first, if they are in range.
+  static constexpr unsigned knumWheelPrimes = 3;
+
+  // Window size when the size of the cache is unknown.
+  static constexpr std::size_t kdefaultWindowBytes = 16384;
+
+  // Number of segments each thread gets in a batch of
+  // sieveSlab. Bounds the primes held outside of the round.
+  static constexpr unsigned kbatchSegmentsPerThread = 16;
+
+  // Span each process sieves before handing its primes over, when
+  // listing them. Bounds the primes held at any time to a couple of
+  // rounds, whatever the size of the range.
+  static constexpr std::uint64_t kstreamSlabSpan = 1ULL << 25;
+
+  // Guided chunks take the numbers left divided by this times the
+  // number of processes, but never less than kminGuidedChunk.
+  static constexpr unsigned kguidedDivisor = 2;
+  static constexpr std::uint64_t kminGuidedChunk = 1ULL << 21;
+
+  // Tags of the chunks sent to the root: the index of the chunk,
+  // then its primes.
+  static constexpr int kchunkIdxTag = 1;
+  static constexpr int kchunkPrimesTag = 2;
+  // Tag of the batches of a pipelined round, plus the parity of the
+  // round.
+  static constexpr int kbatchTag = 3;
+
+  // Forms of each kind of tuplet. See DS::tupletPattern.
+  static std::vector<std::vector<unsigned>> getTupletForms(
+    const tupletKind kind);
+
+  // Window in which a thread marks the segments it sieves.
+  struct threadWindow {
+    threadWindow(const std::size_t numBytes,
+                 std::unique_ptr<segmentProducer<primeType>> producer)
+      : markWindow(numBytes), windowLeftLim(0), markedElemsLeftLim(0),
+        producer(std::move(producer))
+    {}
+
+    // Numbers currently marked as non-primes. Only the numbers
+    // coprime to 30 are stored, and it is allocated according to
+    // the size of the L1 data cache.
+    //
+    // This segment is updated all the time.
+    DS::wheelSegment markWindow;
+
+    // Left limit of markWindow. Always a multiple of the wheel size.
+    primeType windowLeftLim;
+
+    // First number that has not been marked, in markWindow
+    primeType markedElemsLeftLim;
+
+    // Sieves markWindow, the way the engine of the run does.
+    std::unique_ptr<segmentProducer<primeType>> producer;
+
+    // Moves markedElemsLeftLim to the first unmarked number of
+    // markWindow that is not lesser than it. If there is none, it
+    // ends up at the right limit of the window.
+    inline void moveLeftMarkToRight()
+    {
+      const std::size_t bit = markWindow.findUnmarked(
+        DS::wheelSegment::offsetToBit(
+          markedElemsLeftLim - windowLeftLim));
+      markedElemsLeftLim = windowLeftLim +
+        (bit < markWindow.numBits() ?
+         DS::wheelSegment::bitToOffset(bit) : markWindow.span());
+    }
 
-  // Counter of how many elements are marked (i.e. bit set to 1) in
-  // markWindow.
-  unsigned numMarkedElems;
+    // Adds everything unmarked lesser than ~myRightLim~ to the
+    // ~primes~ list! Returns how many were added.
+    inline std::uint64_t allUnmarkedArePrimes(
+      const primeType myRightLim, std::vector<primeType>* primes)
+    {
+      if (myRightLim <= markedElemsLeftLim) {
+        return 0;
+      }
+
+      const std::size_t firstBit = DS::wheelSegment::offsetToBit(
+        Utils::num<primeType>::min(markedElemsLeftLim - windowLeftLim,
+                                   markWindow.span()));
+      const std::size_t lastBit = DS::wheelSegment::offsetToBit(
+        Utils::num<primeType>::min(myRightLim - windowLeftLim,
+                                   markWindow.span()));
+      moveLeftMarkTo(myRightLim);
+      return markWindow.appendUnmarked(firstBit, lastBit, windowLeftLim,
+                                       primes);
+    }
 
-  unsigned windowLeftLim;
+    // The same, but the primes are only counted.
+    inline std::uint64_t countUnmarked(const primeType myRightLim)
+    {
+      const std::size_t firstBit = DS::wheelSegment::offsetToBit(
+        Utils::num<primeType>::min(markedElemsLeftLim - windowLeftLim,
+                                   markWindow.span()));
+      const std::size_t lastBit = DS::wheelSegment::offsetToBit(
+        Utils::num<primeType>::min(myRightLim - windowLeftLim,
+                                   markWindow.span()));
+      moveLeftMarkTo(myRightLim);
+      return markWindow.countUnmarked(firstBit, lastBit);
+    }
 
-  // First number that has not been marked, in markWindow
-  primeT markedElemsLeftLim;
+    // Every number lesser than ~lim~ (or all the window) has already
+    // been processed.
+    inline void moveLeftMarkTo(const primeType lim)
+    {
+      markedElemsLeftLim = Utils::num<primeType>::max(
+        markedElemsLeftLim,
+        Utils::num<primeType>::min(lim,
+                                   windowLeftLim + markWindow.span()));
+    }
 
-  // This is used to broadcast the sizes of each process later on,
-  // in fuseCurPrimesGlobal.
-  unsigned numPrimesInFirstWindow;
+    inline void resetMarkWindow()
+    {
+      markWindow.reset();
+    }
+
+    // Starts the window over with the multiples of the presieve
+    // primes already marked.
+    inline void presieveMarkWindow()
+    {
+      markWindow.presieve(windowLeftLim);
+    }
+  };
+
+  Utils::threadPool pool;
+  // One window per thread of the pool.
+  std::vector<threadWindow> windows;
+
+  // Primes of each segment of a batch of sieveSlab, and how many
+  // there are in it, listed or not. Each list has room for the most
+  // primes a segment may have from the start.
+  std::vector<std::vector<primeType>> segPrimes;
+  std::vector<std::uint64_t> segNumPrimes;
+
+  // Tuplets looked for, if any, and whether the sieve is looking for
+  // them yet, which it does not while finding the sieving primes.
+  const DS::tupletPattern tuplets;
+  bool findingTuplets;
+  // What a segment leaves to the next one in tuplet mode: the primes
+  // of the first and of the last byte of its window, and, among the
+  // latter, the ones that are the first number of a tuplet that may
+  // run into the next window. tailStarts is 0 if the window was not
+  // sieved to its end.
+  struct segBorder {
+    std::uint8_t head;
+    std::uint8_t tail;
+    std::uint8_t tailStarts;
+    primeType tailLeftLim;
+  };
+  std::vector<segBorder> segBorders;
+
+  // Where the primes go. Null in count mode, and in every process
+  // but the root unless config->rankLocalOutput is set.
+  primeSink<primeType>* sink;
+  // Primes of the current and of the previous round, while the
+  // latter is being gathered.
+  std::vector<primeType> roundPrimes[2];
+  // Root only. Buffers of guided chunks already handed to the sink,
+  // to be used again.
+  std::vector<std::vector<primeType>> spareChunks;
+
+  // Pipelined gather. See sievePipelined. Everything is kept for the
+  // two rounds in flight, by the parity of the round. Set while
+  // sieving a pipelined round, so that sieveSlab hands each batch
+  // over to pipelineBatch.
+  bool pipelining;
+  unsigned curParity;
+  // Sends of the batches of the round (all but the root).
+  std::vector<MPI_Request> batchSends[2];
+  // Root only. Primes of every process of the round, received in
+  // place, the receive in flight from each process, and whether
+  // every batch of its slab is in.
+  std::vector<std::vector<primeType>> rankPrimes[2];
+  std::vector<MPI_Request> rankRecvs[2];
+  std::vector<char> rankDone[2];
+  // Output of the number of primes (root process only).
+  std::uint64_t* numPrimes;
+  // Number of primes found by this process.
+  std::uint64_t numPrimesFound;
+
+  // Primes used to mark the windows, i.e. every prime known so far
+  // that is neither a wheel prime nor greater than maxSievingPrime.
+  // Every process reads the same list, which the processes of a host
+  // share.
+  hostPrimeList<primeType> sievingPrimes;
+
+  // Limits of the current round. In each round, the processes split
+  // [roundLeftLim, roundRightLim) evenly between them.
+  primeType roundLeftLim;
+  primeType roundRightLim;
 
   //===--------------------------------------------------------===//
   // Procedures actually used by the algorithm.
   //===--------------------------------------------------------===//
+  void findSievingPrimes();
   void firstPass();
+  void addSmallPrimes();
+  void addSmallTuplets();
+  // Whether ~n~, which is at most userRightLim, is prime, going by
+  // the sieving primes alone.
+  bool isSmallPrime(const primeType n) const;
   void markPrimesLocal();
-  void findPrimesBetween(const unsigned leftLim,
-                         const unsigned rightLim);
-  void fuseCurPrimesGlobal(const unsigned myLeftLim,
-                           const unsigned myRightLim);
-
-  inline unsigned getLLimit() const
+  void streamSlab(const primeType myLeftLim, const primeType myRightLim);
+  std::vector<primeType> getGuidedChunks() const;
+  void sieveGuided();
+  // Root only. Takes in the chunks the other processes sent, and
+  // hands the ones that come next in order to the sink. With
+  // ~wait~, blocks until at least one chunk arrives.
+  void receiveChunks(std::map<std::uint64_t,
+                       std::vector<primeType>>& pending,
+                     std::uint64_t* nextChunk, const bool wait);
+  void emitChunks(std::map<std::uint64_t,
+                    std::vector<primeType>>& pending,
+                  std::uint64_t* nextChunk);
+  void takeChunkBuffer(std::vector<primeType>& primes);
+  void sievePipelined();
+  void pipelineBatch(const primeType* batch, const std::size_t num);
+  void sendBatch(const primeType* batch, const std::size_t num);
+  // Root only. Takes in the batches of the round of parity ~parity~
+  // that arrived. With ~wait~, until the whole round is in.
+  void receiveBatches(const unsigned parity, const bool wait);
+  void emitPipelinedRound(const unsigned parity);
+  std::uint64_t sieveSlab(const primeType myLeftLim,
+                          const primeType myRightLim,
+                          const primeType listRightLim,
+                          std::vector<primeType>* primes);
+  std::uint64_t findPrimesBetween(threadWindow& window,
+                                  const primeType leftLim,
+                                  const primeType rightLim,
+                                  const primeType listRightLim,
+                                  std::vector<primeType>* primes) const;
+  // Tuplets that start in [leftLim, rightLim), in a single window,
+  // sieved up to sieveRightLim. See sieveSlab.
+  std::uint64_t findTupletsBetween(threadWindow& window,
+                                   const primeType leftLim,
+                                   const primeType rightLim,
+                                   const primeType sieveRightLim,
+                                   std::vector<primeType>* primes,
+                                   segBorder* border) const;
+  // Tuplets that start in the last byte of the window of ~prev~ and
+  // end in the first one of the window of ~next~, right after it.
+  std::uint64_t joinSegments(const segBorder& prev,
+                             const segBorder& next,
+                             std::vector<primeType>* primes) const;
+  void shareSievingPrimes(const std::vector<primeType>& myPrimes);
+  void fuseCurPrimesGlobal(std::vector<primeType>& primes);
+  void waitCurPrimesFused(std::vector<primeType>& primes);
+  void countPrimesGlobal();
+
+  // Every prime lesser than roundLeftLim is known, so a round that
+  // looks for sieving primes can go as far as the square of it.
+  inline primeType getSievingRoundRightLim() const
   {
-    const unsigned minLLBase = 
-      Utils::num<unsigned>::min(SQRD(getMaxPrime()), userRightLim);
-    return windowLeftLim + 
-      myProcRank * ceil((minLLBase - windowLeftLim) / 
-                        (float) commSz);
+    return Utils::num<primeType>::min(
+      Utils::num<primeType>::sqrdSat(roundLeftLim),
+      maxSievingPrime + 1);
   }
 
-  inline unsigned getRLimit() const
+  // The interval [roundLeftLim, roundRightLim) is split evenly
+  // between the processes, in multiples of the wheel size.
+  inline primeType getSlabSize() const
   {
-    const unsigned minRLBase = 
-      Utils::num<unsigned>::min(SQRD(getMaxPrime()), userRightLim);
-    const unsigned distFromMinBase = minRLBase - windowLeftLim;
-
-    if (myProcRank == commSz - 1) {
-      return minRLBase;
-    }
-
-    return windowLeftLim + (myProcRank + 1) *
-      floor((minRLBase - windowLeftLim) / (float) commSz);
+    const primeType slabSz =
+      (roundRightLim - roundLeftLim + commSz - 1) / commSz;
+    return slabSz + DS::wheelSegment::kwheelSz - 1
+      - (slabSz + DS::wheelSegment::kwheelSz - 1)
+      % DS::wheelSegment::kwheelSz;
   }
 
-  inline primeT getMaxPrime() const
+  inline primeType getLLimit() const
   {
-    return curPrimes->back();
+    return Utils::num<primeType>::min(
+      roundLeftLim + myProcRank * getSlabSize(), roundRightLim);
   }
 
-  inline void markPrimeAt(const unsigned pos)
+  inline primeType getRLimit() const
   {
-    if (!markWindow[pos]) {
-      markWindow[pos] = 1;
-      ++numMarkedElems;
-    }
-  }
-
-  inline void moveLeftMarkToRight()
-  {
-    while (markWindow[markedElemsLeftLim % markWindow.size()]) {
-      ++markedElemsLeftLim;
-    }
-  }
-
-  // Marks everything and adds it to the curPrimes list!
-  inline void allUnmarkedArePrimes(const unsigned myRightLim)
-  {
-    for (; markedElemsLeftLim < windowLeftLim + markWindow.size()
-           && markedElemsLeftLim < myRightLim;
-         ++markedElemsLeftLim) {
-      if (!markWindow[markedElemsLeftLim - windowLeftLim]) {
-        ++numMarkedElems;           
-        // Don't even need to set markWindow[...] = 1, since the
-        // vector is resetted just after
-        curPrimes->push_back(markedElemsLeftLim);
-      }        
+    if (myProcRank == commSz - 1) {
+      return roundRightLim;
     }
-    resetMarkWindow();
-  }
 
-  inline void resetMarkWindow()
-  {
-    markWindow.reset();
-    numMarkedElems = 0;
+    return Utils::num<primeType>::min(
+      roundLeftLim + (myProcRank + 1) * getSlabSize(), roundRightLim);
   }
 };
 
 }
 
-#undef SQRD
 #endif
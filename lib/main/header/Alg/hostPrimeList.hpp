@@ -0,0 +1,315 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: definition of class ~hostPrimeList~.
+//
+// Description: a sorted list of primes that every process of a
+// communicator reads in full, such as the sieving primes of
+// eratSieve. The processes that run on the same host share a single
+// copy of it, in a window of shared memory written by the first of
+// them (the host leader). Only the leaders exchange primes with one
+// another. So the memory and the traffic of the list grow with the
+// number of hosts, rather than with the number of processes.
+//
+// A process that is alone on its host keeps the list in memory of
+// its own, and so does a communicator of a single process, which
+// skips MPI altogether. Either way, the room for every prime up to
+// the largest one is taken at once.
+//===----------------------------------------------------------===//
+
+#ifndef HOSTPRIMELIST_H
+#define HOSTPRIMELIST_H
+
+#include "DS/pageArena.hpp"
+#include "DS/primeBounds.hpp"
+#include "Utils/mpiType.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mpi.h"
+
+namespace Alg {
+
+template <typename primeType>
+class hostPrimeList {
+public:
+  // The list will hold primes up to ~maxPrime~ at most. Every
+  // process of ~comm~ has to construct it, and to destroy it.
+  hostPrimeList(MPI_Comm comm, const primeType maxPrime)
+    : comm(comm), hostComm(MPI_COMM_NULL), leaderComm(MPI_COMM_NULL),
+      win(MPI_WIN_NULL), base(nullptr), capacity(0), sz(0),
+      commSz(1), hostSz(1), hostRank(0), numHosts(1)
+  {
+    MPI_Comm_size(comm, &commSz);
+    if (commSz == 1) {
+      DS::pageArena::reserveHuge(own, getMaxNumPrimes(maxPrime));
+      return;
+    }
+
+    int myProcRank;
+    MPI_Comm_rank(comm, &myProcRank);
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, myProcRank,
+                        MPI_INFO_NULL, &hostComm);
+    MPI_Comm_size(hostComm, &hostSz);
+    MPI_Comm_rank(hostComm, &hostRank);
+    MPI_Comm_split(comm, isWriter() ? 0 : MPI_UNDEFINED, myProcRank,
+                   &leaderComm);
+
+    // Host of every process, numbered after the rank of its leader.
+    int myHost = 0;
+    if (isWriter()) {
+      MPI_Comm_rank(leaderComm, &myHost);
+    }
+    MPI_Bcast(&myHost, 1, MPI_INT, 0, hostComm);
+    hostOf.resize(commSz);
+    MPI_Allgather(&myHost, 1, MPI_INT, hostOf.data(), 1, MPI_INT,
+                  comm);
+    for (const int host : hostOf) {
+      numHosts = std::max(numHosts, host + 1);
+    }
+
+    if (hostSz > 1) {
+      capacity = getMaxNumPrimes(maxPrime);
+      MPI_Win_allocate_shared(
+        isWriter() ? capacity * sizeof(primeType) : 0,
+        sizeof(primeType), MPI_INFO_NULL, hostComm, &base, &win);
+      if (!isWriter()) {
+        MPI_Aint winSz;
+        int dispUnit;
+        MPI_Win_shared_query(win, 0, &winSz, &dispUnit, &base);
+      }
+      MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+    }
+    else {
+      DS::pageArena::reserveHuge(own, getMaxNumPrimes(maxPrime));
+    }
+  }
+
+  ~hostPrimeList()
+  {
+    if (win != MPI_WIN_NULL) {
+      MPI_Win_unlock_all(win);
+      MPI_Win_free(&win);
+    }
+    if (leaderComm != MPI_COMM_NULL) {
+      MPI_Comm_free(&leaderComm);
+    }
+    if (hostComm != MPI_COMM_NULL) {
+      MPI_Comm_free(&hostComm);
+    }
+  }
+
+  hostPrimeList(const hostPrimeList&) = delete;
+  hostPrimeList& operator=(const hostPrimeList&) = delete;
+
+  inline const primeType* data() const
+  {
+    return win != MPI_WIN_NULL ? base : own.data();
+  }
+
+  inline std::size_t size() const
+  {
+    return sz;
+  }
+
+  inline const primeType* begin() const
+  {
+    return data();
+  }
+
+  inline const primeType* end() const
+  {
+    return data() + sz;
+  }
+
+  inline const primeType& operator[](const std::size_t i) const
+  {
+    return data()[i];
+  }
+
+  // Whether this process writes the list of its host. The others
+  // leave the primes they pass to the calls below unused.
+  inline bool isWriter() const
+  {
+    return hostRank == 0;
+  }
+
+  // Sets the list to ~primes~, which only the host leaders need to
+  // have. Every process of the host has to call it.
+  void assign(const std::vector<primeType>& primes) noexcept(false)
+  {
+    if (isWriter()) {
+      sz = 0;
+      append(primes.data(), primes.size());
+    }
+    publish();
+  }
+
+  // Appends the primes every process of the communicator passes,
+  // in the order of their ranks. Every process has to call it.
+  void appendAll(const std::vector<primeType>& myPrimes)
+    noexcept(false)
+  {
+    if (commSz == 1) {
+      append(myPrimes.data(), myPrimes.size());
+      return;
+    }
+
+    const int myNumPrimes = myPrimes.size();
+    std::vector<int> numPrimes(commSz);
+    MPI_Allgather(&myNumPrimes, 1, MPI_INT, numPrimes.data(), 1,
+                  MPI_INT, comm);
+
+    // The leader of each host collects the primes of its processes,
+    // then the leaders trade what they have. A single host is already
+    // in the order of the ranks, so its primes go straight to the
+    // list.
+    std::vector<int> hostNumPrimes(isWriter() ? hostSz : 0);
+    MPI_Gather(&myNumPrimes, 1, MPI_INT, hostNumPrimes.data(), 1,
+               MPI_INT, 0, hostComm);
+    std::vector<primeType> hostPrimes;
+    std::vector<int> displs;
+    primeType* recvBuf = nullptr;
+    std::size_t hostTotal = 0;
+    if (isWriter()) {
+      hostTotal = prefixSums(hostNumPrimes, &displs);
+      if (numHosts == 1) {
+        recvBuf = reserveAppend(hostTotal);
+      }
+      else {
+        hostPrimes.resize(hostTotal);
+        recvBuf = hostPrimes.data();
+      }
+    }
+    MPI_Gatherv(myPrimes.data(), myNumPrimes,
+                Utils::mpiType<primeType>::get(), recvBuf,
+                hostNumPrimes.data(), displs.data(),
+                Utils::mpiType<primeType>::get(), 0, hostComm);
+
+    if (isWriter() && numHosts == 1) {
+      sz += hostTotal;
+    }
+    else if (isWriter()) {
+      const int myHostNumPrimes = hostPrimes.size();
+      std::vector<int> allHostNumPrimes(numHosts);
+      MPI_Allgather(&myHostNumPrimes, 1, MPI_INT,
+                    allHostNumPrimes.data(), 1, MPI_INT, leaderComm);
+      std::vector<int> hostDispls;
+      std::vector<primeType> allPrimes(
+        prefixSums(allHostNumPrimes, &hostDispls));
+      MPI_Allgatherv(hostPrimes.data(), myHostNumPrimes,
+                     Utils::mpiType<primeType>::get(),
+                     allPrimes.data(), allHostNumPrimes.data(),
+                     hostDispls.data(),
+                     Utils::mpiType<primeType>::get(), leaderComm);
+
+      hostPrimes.clear();
+      hostPrimes.shrink_to_fit();
+
+      // The primes of a host are in the order of the ranks of its
+      // processes, so they are put back in the order of all ranks
+      // one process at a time.
+      for (int rank = 0; rank < commSz; ++rank) {
+        int& next = hostDispls[hostOf[rank]];
+        append(allPrimes.data() + next, numPrimes[rank]);
+        next += numPrimes[rank];
+      }
+    }
+    publish();
+  }
+
+private:
+  MPI_Comm comm;
+  // Processes of this host, and the leaders of all hosts (only in
+  // the leaders).
+  MPI_Comm hostComm;
+  MPI_Comm leaderComm;
+  // Shared window of the host, and its memory, if the host has more
+  // than one process. Otherwise, the list lives in ~own~.
+  MPI_Win win;
+  primeType* base;
+  std::size_t capacity;
+  std::vector<primeType> own;
+  std::size_t sz;
+
+  int commSz;
+  int hostSz;
+  int hostRank;
+  int numHosts;
+  // Host of each process of comm.
+  std::vector<int> hostOf;
+
+  // Writer only. Room for ~numPrimes~ more primes at the end of the
+  // list, which only count once added to sz.
+  primeType* reserveAppend(const std::size_t numPrimes)
+    noexcept(false)
+  {
+    if (win == MPI_WIN_NULL) {
+      own.resize(sz + numPrimes);
+      return own.data() + sz;
+    }
+    if (sz + numPrimes > capacity) {
+      throw std::logic_error{
+        "More than " + std::to_string(capacity) +
+          " primes in a shared prime list"};
+    }
+    return base + sz;
+  }
+
+  // Writer only.
+  void append(const primeType* primes, const std::size_t numPrimes)
+    noexcept(false)
+  {
+    std::memcpy(reserveAppend(numPrimes), primes,
+                numPrimes * sizeof(primeType));
+    sz += numPrimes;
+  }
+
+  // Makes what the leader wrote visible to the rest of the host.
+  void publish()
+  {
+    if (hostComm == MPI_COMM_NULL) {
+      return;
+    }
+    std::uint64_t newSz = sz;
+    if (win != MPI_WIN_NULL && isWriter()) {
+      MPI_Win_sync(win);
+    }
+    MPI_Bcast(&newSz, 1, MPI_UINT64_T, 0, hostComm);
+    if (win != MPI_WIN_NULL && !isWriter()) {
+      MPI_Win_sync(win);
+    }
+    sz = newSz;
+  }
+
+  // Fills ~displs~ with the sums of the counts before each one, and
+  // returns the sum of all of them.
+  static std::size_t prefixSums(const std::vector<int>& counts,
+                                std::vector<int>* displs)
+  {
+    displs->assign(counts.size(), 0);
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+      (*displs)[i] = sum;
+      sum += counts[i];
+    }
+    return sum;
+  }
+
+  static std::size_t getMaxNumPrimes(const primeType x)
+  {
+    const std::size_t kminCapacity = 64;
+    return std::max<std::size_t>(
+      kminCapacity, DS::primeBounds::maxPrimesUpTo(x));
+  }
+};
+
+}
+
+#endif
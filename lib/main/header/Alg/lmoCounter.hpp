@@ -0,0 +1,122 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: declaration of class ~lmoCounter~.
+//
+// Description: counts the primes up to x without sieving up to x,
+// with the method of Lagarias, Miller and Odlyzko (LMO), as laid
+// out by Deleglise and Rivat. For y >= x^(1/3),
+//
+//   pi(x) = phi(x, a) + a - 1 - P2(x, a),    a = pi(y),
+//
+// where phi(x, a) counts the numbers up to x with no prime factor
+// among the first a primes, and P2 counts the numbers up to x made
+// of exactly two primes greater than y. phi(x, a) is split into the
+// ordinary leaves S1, which take a formula each, and the special
+// leaves S2, which are read off a segmented sieve of [0, x / y].
+// P2 takes a plain count of the primes up to x / y. So the sieving
+// goes up to about x^(2/3) instead of x.
+//
+// The first 3 primes are left out of the leaves: the sieve is a
+// wheelSegment, which never holds their multiples to begin with.
+//
+// S2 and P2 are split between the processes (and threads) in
+// contiguous slabs. Every slab counts phi relative to its own left
+// limit, and a scan of the counts of the slabs before it fixes the
+// leaves up afterwards.
+//===----------------------------------------------------------===//
+
+#ifndef LMOCOUNTER_H
+#define LMOCOUNTER_H
+
+#include "Alg/eratSieve.hpp"
+#include "Alg/sieveConfig.hpp"
+#include "Utils/hwInfo.hpp"
+#include "Utils/threadPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mpi.h"
+
+namespace Alg {
+
+class lmoCounter {
+public:
+  // Counts the primes up to ~x~ into ~numPrimes~. Every process of
+  // config->comm has to take part, and all of them get the count.
+  lmoCounter(const Utils::cacheInfo*, const sieveConfig*,
+             const primeT x, std::uint64_t* numPrimes)
+    noexcept(false);
+
+  // Whether counting the primes in [leftLim, rightLim] as
+  // pi(rightLim) - pi(leftLim - 1) beats sieving them.
+  static bool beatsSieve(const primeT leftLim, const primeT rightLim);
+
+private:
+  // Below this, everything is just sieved.
+  static constexpr primeT kminLimit = 1000;
+  // The wheel primes 2, 3 and 5, left out of the leaves.
+  static constexpr unsigned knumWheelPrimes = 3;
+  // Span of the pieces P2 is counted in, which bounds the primes
+  // listed at once.
+  static constexpr primeT kp2ChunkSpan = 1ULL << 26;
+  // y = kalpha * x^(1/3).
+  static constexpr long double kalpha = 2;
+  // Largest segment of the sieve of S2.
+  static constexpr std::size_t kmaxSegmentBytes = 1 << 16;
+  // Work of LMO, in units of x^(2/3), against a sieve of the same
+  // range (see beatsSieve).
+  static constexpr long double kcostRatio = 1;
+
+  const Utils::cacheInfo* cinfo;
+  const sieveConfig* config;
+  const primeT x;
+  // Leaves stop at y, and the sieve of S2 goes up to x / y.
+  const primeT y;
+  const primeT z;
+
+  int myProcRank;
+  int commSz;
+  Utils::threadPool pool;
+
+  // primes[i] is the i-th prime (primes[0] is unused), up to y.
+  std::vector<primeT> primes;
+  // pi, Moebius function and least prime factor of every number up
+  // to y. lpf[1] is greater than every prime.
+  std::vector<std::uint32_t> pi;
+  std::vector<std::int8_t> mu;
+  std::vector<std::uint32_t> lpf;
+
+  // What a slab of the sieve of S2 leaves behind. ~phi[b]~ is the
+  // count of numbers in the slab with no factor among the first
+  // ~b - 1~ primes, ~muSum[b]~ the sum of -mu(m) over the leaves of
+  // ~primes[b]~ in the slab, and ~sum~ the leaves, with phi counted
+  // from the left limit of the slab.
+  struct leafSlab {
+    std::vector<std::uint64_t> phi;
+    std::vector<std::uint64_t> muSum;
+    std::uint64_t sum;
+  };
+
+  // Every sum below wraps around modulo 2^64. pi(x) itself fits, so
+  // the result comes out right.
+  std::uint64_t countAll() noexcept(false);
+  void buildTables() noexcept(false);
+  std::uint64_t computeS1() const;
+  std::uint64_t computeS2() noexcept(false);
+  void sieveLeaves(const std::size_t firstSeg,
+                   const std::size_t lastSeg, leafSlab* slab) const;
+  std::uint64_t computeP2(std::uint64_t* numP2Primes) noexcept(false);
+
+  // Configuration of the sieves that only this process runs.
+  sieveConfig getLocalConfig() const;
+  std::size_t getSegmentBytes() const;
+
+  static primeT getY(const primeT x);
+};
+
+}
+
+#endif
@@ -0,0 +1,53 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: declaration of class ~nthPrime~.
+//
+// Description: finds the n-th prime without listing the primes
+// before it. Analytic bounds of Dusart put p_n in a narrow interval
+// [lower, upper]. The primes below the lower bound are only counted,
+// with primeCounter, and only the interval itself is listed, to pick
+// p_n out of it. For n = 1e9 the interval is about 0.1% as wide as
+// the range counted.
+//===----------------------------------------------------------===//
+
+#ifndef NTHPRIME_H
+#define NTHPRIME_H
+
+#include "Alg/eratSieve.hpp"
+#include "Alg/sieveConfig.hpp"
+#include "Utils/hwInfo.hpp"
+
+#include <cstdint>
+
+namespace Alg {
+
+class nthPrime {
+public:
+  // pi(1e19), the index of the largest prime the sieve can reach.
+  static constexpr std::uint64_t kmaxIndex = 234057667276344607ULL;
+
+  // The ~n~-th prime, counting from p_1 = 2. Every process of
+  // config.comm has to call it, and all of them get the result.
+  // config.countOnly and config.rankLocalOutput are ignored.
+  static primeT find(const Utils::cacheInfo*, const sieveConfig&,
+                     const std::uint64_t n) noexcept(false);
+
+  // Bounds of the ~n~-th prime, which is in [getLowerBound(n),
+  // getUpperBound(n)]. 1 <= n <= kmaxIndex
+  static primeT getLowerBound(const std::uint64_t n);
+  static primeT getUpperBound(const std::uint64_t n);
+
+private:
+  // p_n is greater than 1e19 past kmaxIndex.
+  static constexpr primeT kmaxPrime = 10000000000000000000ULL;
+  // The tighter upper bound only holds from this index on.
+  static constexpr std::uint64_t kminTightUpperIndex = 27076;
+  // Relative room left around the bounds, for the rounding of the
+  // floating point arithmetic.
+  static constexpr long double kboundSlack = 1e-12L;
+};
+
+}
+
+#endif
@@ -0,0 +1,36 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: declaration of class ~primeCounter~.
+//
+// Description: counts the primes of a range, either by sieving the
+// whole of it with eratSieve, or as a difference of two counts of
+// lmoCounter. The latter only costs about x^(2/3), so it wins
+// unless the range is narrow next to its right limit.
+//===----------------------------------------------------------===//
+
+#ifndef PRIMECOUNTER_H
+#define PRIMECOUNTER_H
+
+#include "Alg/eratSieve.hpp"
+#include "Alg/sieveConfig.hpp"
+#include "Utils/hwInfo.hpp"
+
+#include <cstdint>
+
+namespace Alg {
+
+class primeCounter {
+public:
+  // Number of primes in [leftLim, rightLim], found the way
+  // config.counter says. Every process of config.comm has to call
+  // it, and all of them get the count. config.countOnly and
+  // config.rankLocalOutput are ignored.
+  static std::uint64_t count(const Utils::cacheInfo*,
+                             const sieveConfig&, const primeT leftLim,
+                             const primeT rightLim) noexcept(false);
+};
+
+}
+
+#endif
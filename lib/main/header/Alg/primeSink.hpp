@@ -0,0 +1,43 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: declaration of the ~primeSink~ interface.
+//
+// Description: eratSieve does not keep the primes it lists. As soon
+// as a chunk of them is ready, in order, it is handed over to a
+// sink, which may write them somewhere, keep them, or anything else.
+//===----------------------------------------------------------===//
+
+#ifndef PRIMESINK_H
+#define PRIMESINK_H
+
+#include <vector>
+
+namespace Alg {
+
+template <typename primeType>
+class primeSink {
+public:
+  virtual ~primeSink() {}
+
+  // Called once, before anything else. Every prime the sink is going
+  // to receive is in [leftLim, rightLim]. The range may be empty,
+  // with leftLim == rightLim + 1.
+  virtual void start(const primeType leftLim, const primeType rightLim)
+    noexcept(false) = 0;
+
+  // Receives the next primes, all of them greater than the ones
+  // received before. The sink is free to take the contents of
+  // ~primes~, and leave it empty. The sieve fills the same buffer
+  // again afterwards, so a sink that takes it should leave one with
+  // as much room in its place.
+  virtual void consume(std::vector<primeType>& primes)
+    noexcept(false) = 0;
+
+  // No more primes are coming.
+  virtual void finish() noexcept(false) = 0;
+};
+
+}
+
+#endif
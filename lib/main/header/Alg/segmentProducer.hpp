@@ -0,0 +1,48 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: declaration of the ~segmentProducer~ interface.
+//
+// Description: the kernel of a sieve engine. eratSieve decides which
+// numbers are sieved, by which process and thread, and where the
+// primes go, but leaves the sieving of each window to a producer of
+// the engine picked for the run, one per thread. Given a window, a
+// producer marks the composites in it, in whatever way it likes.
+// See sieveEngine.
+//===----------------------------------------------------------===//
+
+#ifndef SEGMENTPRODUCER_H
+#define SEGMENTPRODUCER_H
+
+#include "DS/wheelSegment.hpp"
+
+#include <cstddef>
+
+namespace Alg {
+
+template <typename primeType>
+class segmentProducer {
+public:
+  virtual ~segmentProducer() {}
+
+  // Sieving primes from now on: every prime from 7 on, in order, up
+  // to at least the square root of anything produce is asked for.
+  // They stay in place until the next call, which comes before
+  // every slab.
+  virtual void start(const primeType* sievingPrimes,
+                     const std::size_t numSievingPrimes)
+    noexcept(false) = 0;
+
+  // Sieves ~segment~, which starts at ~leftLim~, a multiple of the
+  // wheel size: the composites lesser than ~rightLim~ end up marked,
+  // and the primes do not. Whatever comes after rightLim may be
+  // left either way. The segments a producer gets are mostly one
+  // right after the other.
+  virtual void produce(DS::wheelSegment& segment,
+                       const primeType leftLim,
+                       const primeType rightLim) noexcept(false) = 0;
+};
+
+}
+
+#endif
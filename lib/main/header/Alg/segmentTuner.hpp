@@ -0,0 +1,50 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: declaration of class ~segmentTuner~.
+//
+// Description: picks the window size of the sieve for the machine
+// at hand. The candidates come from the sizes of every level of
+// cache, and each of them is timed counting the primes of a short
+// range. The best size depends on more than the L1 cache: large
+// sieving primes go through buckets, which favour larger windows,
+// while the small ones want windows that stay close to the core.
+//===----------------------------------------------------------===//
+
+#ifndef SEGMENTTUNER_H
+#define SEGMENTTUNER_H
+
+#include "Alg/eratSieve.hpp"
+#include "Alg/sieveConfig.hpp"
+#include "Utils/hwInfo.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace Alg {
+
+class segmentTuner {
+public:
+  // Window sizes worth trying, in bytes and in increasing order.
+  static std::vector<std::size_t> getCandidates();
+
+  // Counts the primes of [leftLim, rightLim] with each candidate and
+  // returns the fastest one. Everything but the window size and the
+  // output mode is taken from ~config~, so config.comm must only
+  // hold processes that run on this machine.
+  static std::size_t findBestWindowBytes(const Utils::cacheInfo*,
+                                         const sieveConfig& config,
+                                         const primeT leftLim,
+                                         const primeT rightLim);
+
+private:
+  // Each candidate is timed this many times, and the best time
+  // counts. Keeps one-off hiccups from deciding.
+  static constexpr unsigned knumRepetitions = 3;
+  // Candidates smaller than this are not even tried.
+  static constexpr std::size_t kminCandidateBytes = 4096;
+};
+
+}
+
+#endif
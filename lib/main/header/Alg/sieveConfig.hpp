@@ -0,0 +1,93 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: definition of the ~sieveConfig~ struct, which
+// carries the tunable knobs of the sieve from the Interface module
+// to the algorithm.
+//===----------------------------------------------------------===//
+
+#ifndef SIEVECONFIG_H
+#define SIEVECONFIG_H
+
+#include <cstddef>
+#include <string>
+
+#include "mpi.h"
+
+namespace Alg {
+
+// How primes are counted. See primeCounter.
+enum class countMethod {
+  // Whichever of the two below is cheaper for the range.
+  automatic,
+  // Sieve the whole range.
+  sieve,
+  // Count with lmoCounter.
+  lmo
+};
+
+// How the range is split between the processes. See eratSieve.
+enum class scheduleMode {
+  // Every process gets a slab of the same width.
+  even,
+  // Processes claim chunks of the range as they go, bigger first.
+  guided
+};
+
+// How the primes found by the processes reach the root, when they
+// are listed with an even schedule. See eratSieve.
+enum class gatherMode {
+  // All at once, at the end of each round.
+  round,
+  // Batch by batch, as soon as each one is sieved.
+  pipelined
+};
+
+// Prime constellations looked for instead of the primes. See
+// eratSieve.
+enum class tupletKind {
+  // Just the primes.
+  none,
+  // p, p + 2
+  twins,
+  // p, p + 4
+  cousins,
+  // p, p + 2, p + 6 and p, p + 4, p + 6
+  triplets,
+  // p, p + 2, p + 6, p + 8
+  quadruplets
+};
+
+struct sieveConfig {
+  // Number of threads each process uses to sieve its slab.
+  unsigned numThreads = 1;
+  // Only count the primes. The list of primes is never built, and
+  // each segment is discarded as soon as it is counted.
+  bool countOnly = false;
+  // Bytes of the window each thread sieves in. 0 means half of the
+  // L1 data cache.
+  std::size_t windowBytes = 0;
+  // Every process hands the primes of its own slab to its own sink,
+  // instead of gathering them all into the root. The slabs are
+  // contiguous and ordered by rank.
+  bool rankLocalOutput = false;
+  // How the range is split between the processes. Output by rank
+  // always splits it evenly.
+  scheduleMode schedule = scheduleMode::even;
+  // How the listed primes are gathered with an even schedule.
+  gatherMode gather = gatherMode::pipelined;
+  // With anything but none, eratSieve finds the tuplets of this
+  // kind instead of the primes, each one by its first prime.
+  tupletKind tuplets = tupletKind::none;
+  // Name of the engine that sieves the windows. Empty means the one
+  // that suits the range best. See sieveEngine.
+  std::string engine;
+  // How a range is counted, when only its count is wanted.
+  countMethod counter = countMethod::automatic;
+  // Processes that share the work.
+  MPI_Comm comm = MPI_COMM_WORLD;
+};
+
+}
+
+#endif
@@ -0,0 +1,75 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: declaration of class ~sieveEngine~.
+//
+// Description: the sieve engines a run may use, by name. An engine
+// is a way of sieving the windows, i.e. a kind of segmentProducer,
+// while the rest of the run (the sieving primes, the split of the
+// range between processes and threads, the gather and the sinks) is
+// up to eratSieve, whatever the engine. So engines can be compared
+// on the same build, the same ranges and the same output.
+//
+// The ones built in are
+//
+//   eratosthenes   the sieve of Eratosthenes. See eratProducer.
+//   atkin          the sieve of Atkin. See atkinProducer.
+//
+// and more can be added at run time.
+//===----------------------------------------------------------===//
+
+#ifndef SIEVEENGINE_H
+#define SIEVEENGINE_H
+
+#include "Alg/segmentProducer.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Alg {
+
+template <typename primeType>
+class sieveEngine {
+public:
+  // Makes the producer of a thread, for windows of ~windowBytes~
+  // bytes.
+  typedef std::unique_ptr<segmentProducer<primeType>> (*createFn)(
+    const std::size_t windowBytes);
+  // Whether the engine is the one to use for [leftLim, rightLim],
+  // when none is asked for.
+  typedef bool (*suitsFn)(const primeType leftLim,
+                          const primeType rightLim);
+
+  struct entry {
+    std::string name;
+    createFn create;
+    // Null if the engine is only used when asked for.
+    suitsFn suits;
+  };
+
+  // Adds an engine under ~name~, which must not be taken.
+  static void add(const std::string& name, const createFn create,
+                  const suitsFn suits) noexcept(false);
+
+  // The engine added under ~name~.
+  static const entry& find(const std::string& name) noexcept(false);
+
+  // The engine to use for [leftLim, rightLim] when none is asked
+  // for: the last one added that suits it. Eratosthenes suits every
+  // range.
+  static const entry& pick(const primeType leftLim,
+                           const primeType rightLim);
+
+  // Names of every engine, in the order they were added.
+  static std::vector<std::string> getNames();
+
+private:
+  // Every engine added so far, starting with the ones built in.
+  static std::vector<entry>& getEntries();
+};
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+//===----------------------------------------------------------===//
+// Alg module
+//
+// File purpose: ~vectorSink~ class declaration and definition.
+//
+// Description: a sink that appends every prime it gets to a vector.
+// The vector is given room for every prime of the range at the
+// start, so it never grows along the way, and the buffers of the
+// sieve are left alone.
+//===----------------------------------------------------------===//
+
+#ifndef VECTORSINK_H
+#define VECTORSINK_H
+
+#include "Alg/primeSink.hpp"
+#include "DS/pageArena.hpp"
+#include "DS/primeBounds.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Alg {
+
+template <typename primeType>
+class vectorSink : public primeSink<primeType> {
+public:
+  explicit vectorSink(std::vector<primeType>* out)
+    : out(out)
+  {}
+
+  void start(const primeType leftLim, const primeType rightLim)
+    override
+  {
+    if (leftLim <= rightLim) {
+      DS::pageArena::reserveHuge(
+        *out, out->size() + DS::primeBounds::maxPrimesBetween(
+          leftLim, static_cast<std::uint64_t>(rightLim) + 1));
+    }
+  }
+
+  void consume(std::vector<primeType>& primes) override
+  {
+    out->insert(out->end(), primes.begin(), primes.end());
+  }
+
+  void finish() override
+  {}
+
+private:
+  std::vector<primeType>* out;
+};
+
+}
+
+#endif
@@ -9,5 +9,11 @@
 #define DS_H
 
 #include "array.hpp"
+#include "pageArena.hpp"
+#include "primeBounds.hpp"
+#include "primeCache.hpp"
+#include "tupletPattern.hpp"
+#include "wheelBuckets.hpp"
+#include "wheelSegment.hpp"
 
 #endif
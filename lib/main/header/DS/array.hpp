@@ -10,6 +10,7 @@
 #include <cstring>
 #include <stdexcept>
 #include <string>
+#include <utility>
 
 namespace DS {
 
@@ -17,12 +18,14 @@ template <typename valueType>
 class array {
 public:
   // Creates an array of size ~size~, and fills it with ~val~
-  array(const unsigned size, const valueType& val) : arrSz(size)
+  array(const unsigned size, const valueType& val)
+    : arrSz(size), innerArr(nullptr)
   {
     fill(val);
   }
 
   array(const int size, const valueType& val)
+    : arrSz(0), innerArr(nullptr)
   {
     checkPositiveSize(size);
 
@@ -36,28 +39,26 @@ public:
   array() : arrSz(0), innerArr(nullptr) {}
 
   // Move-constructor -- called when we have rvalue parameters.
-  array(array&& rhs)
+  array(array&& rhs) noexcept
+    : arrSz(rhs.arrSz), innerArr(rhs.innerArr)
   {
-    arrSz = rhs.arrSz;
-    if (innerArr) {
-      delete[] innerArr;
-    }
-
-    innerArr = rhs.innerArr;
-
     // Nullify rhs
     rhs.innerArr = nullptr;
     rhs.arrSz = 0;
   }
 
-  array& operator =(array&& rhs)
+  // Our old contents go away along with rhs.
+  array& operator =(array&& rhs) noexcept
   {
-    array{rhs};
+    std::swap(arrSz, rhs.arrSz);
+    std::swap(innerArr, rhs.innerArr);
     return *this;
   }
   // End move-constructors
-  
-  // Copy-constructors
+
+  // Copies would share innerArr.
+  array(const array&) = delete;
+  array& operator =(const array&) = delete;
 
   ~array()
   {
@@ -67,7 +68,7 @@ public:
   // Access
   valueType& at(const unsigned pos)
   {
-    if (pos > arrSz) {
+    if (pos >= arrSz) {
       throw std::out_of_range{
         std::string("Position ") + std::to_string(pos) +
           " is out of range"};
@@ -76,7 +77,7 @@ public:
   }
 
   // Container information
-  unsigned size()
+  unsigned size() const
   {
     return arrSz;
   }
@@ -94,7 +95,7 @@ private:
   {
     innerArr = new valueType[arrSz];
     
-    register unsigned int i = 0;
+    unsigned int i = 0;
     for (; i < arrSz; ++i) {
       innerArr[i] = val;
     }
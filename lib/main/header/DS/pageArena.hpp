@@ -0,0 +1,82 @@
+//===----------------------------------------------------------===//
+// DS module
+//
+// File purpose: ~pageArena~ class declaration.
+//
+// Description: a block of memory mapped straight from the system,
+// for the buffers of the sieve that are sized once, before it
+// starts, and then reused for as long as it runs. Blocks of a huge
+// page (2 MB) or more are asked to be backed by huge pages, which
+// takes pressure off the TLB when a buffer is walked end to end:
+// first with MAP_HUGETLB, if the system has huge pages set aside,
+// and otherwise by advising transparent huge pages.
+//
+// The same advice can be given for the memory of a std::vector,
+// through reserveHuge, so that the buffers that are handed over to
+// the sinks get it as well.
+//===----------------------------------------------------------===//
+
+#ifndef PAGEARENA_H
+#define PAGEARENA_H
+
+#include <cstddef>
+#include <vector>
+
+namespace DS {
+
+class pageArena {
+public:
+  static constexpr std::size_t khugePageBytes = 1 << 21;
+
+  pageArena();
+  // Maps at least ~numBytes~ bytes, all of them zero.
+  explicit pageArena(const std::size_t numBytes) noexcept(false);
+  ~pageArena();
+
+  pageArena(pageArena&& rhs) noexcept;
+  pageArena& operator=(pageArena&& rhs) noexcept;
+  pageArena(const pageArena&) = delete;
+  pageArena& operator=(const pageArena&) = delete;
+
+  inline void* data() const
+  {
+    return base;
+  }
+
+  inline std::size_t size() const
+  {
+    return numBytes;
+  }
+
+  // Makes sure there are at least ~minBytes~ bytes. If there are
+  // not, the old ones are dropped, along with what they held.
+  void reserve(const std::size_t minBytes) noexcept(false);
+
+  // Asks for the huge pages that fit entirely in the ~numBytes~
+  // bytes at ~addr~ to be backed by huge pages. It is only advice,
+  // so it never fails.
+  static void adviseHugePages(void* addr, const std::size_t numBytes);
+
+  // Reserves room for exactly ~capacity~ elements in ~vec~, in huge
+  // pages if it is large enough, unless it already has it.
+  template <typename T>
+  static void reserveHuge(std::vector<T>& vec,
+                          const std::size_t capacity) noexcept(false)
+  {
+    if (vec.capacity() >= capacity) {
+      return;
+    }
+    vec.reserve(capacity);
+    adviseHugePages(vec.data(), capacity * sizeof(T));
+  }
+
+private:
+  void* base;
+  std::size_t numBytes;
+
+  void unmap();
+};
+
+}
+
+#endif
@@ -0,0 +1,97 @@
+//===----------------------------------------------------------===//
+// DS module
+//
+// File purpose: ~primeBounds~ class declaration and definition.
+//
+// Description: proven bounds on the number of primes in a range,
+// so that buffers of primes can be given their whole capacity
+// before the sieve starts, and never grow while it runs. They are
+//
+//   pi(x) <= x / ln x * (1 + 1 / ln x + 2.51 / ln^2 x), x >= 355991
+//   pi(x) >= x / ln x * (1 + 1 / ln x),                  x >= 599
+//   (Dusart, 2010)
+//
+//   pi(x) < 1.25506 * x / ln x,                          x > 1
+//   pi(x) > x / ln x,                                    x >= 17
+//   (Rosser and Schoenfeld, 1962)
+//
+//   pi(x + y) - pi(x) <= 2 * y / ln y,                   y > 1
+//   (Montgomery and Vaughan, 1973)
+//
+// and, for short ranges, the numbers coprime to the wheel. Every
+// bound is rounded away from the truth, to make up for floating
+// point.
+//===----------------------------------------------------------===//
+
+#ifndef PRIMEBOUNDS_H
+#define PRIMEBOUNDS_H
+
+#include "DS/wheelSegment.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace DS {
+
+class primeBounds {
+public:
+  // At least pi(x).
+  static inline std::uint64_t maxPrimesUpTo(const std::uint64_t x)
+  {
+    if (x < 2) {
+      return 0;
+    }
+    const long double lx = std::log(static_cast<long double>(x));
+    const long double bound = x < 355991 ?
+      1.25506L * x / lx :
+      x / lx * (1 + 1 / lx + 2.51L / (lx * lx));
+    return static_cast<std::uint64_t>(bound) + 1;
+  }
+
+  // At most pi(x).
+  static inline std::uint64_t minPrimesUpTo(const std::uint64_t x)
+  {
+    if (x < 17) {
+      return 0;
+    }
+    const long double lx = std::log(static_cast<long double>(x));
+    const long double bound = x < 599 ?
+      x / lx : x / lx * (1 + 1 / lx);
+    return static_cast<std::uint64_t>(bound) - 1;
+  }
+
+  // At least the number of primes in any ~span~ consecutive
+  // numbers, wherever they are.
+  static inline std::uint64_t maxPrimesInSpan(const std::uint64_t span)
+  {
+    // Only the numbers coprime to the wheel, and the primes of the
+    // wheel itself.
+    const std::uint64_t bound = (span + wheelSegment::kwheelSz - 1)
+      / wheelSegment::kwheelSz * wheelSegment::knumResidues + 3;
+    if (span < 2) {
+      return std::min<std::uint64_t>(bound, span);
+    }
+    const long double shortBound =
+      2 * span / std::log(static_cast<long double>(span));
+    return std::min<std::uint64_t>(
+      bound, static_cast<std::uint64_t>(shortBound) + 1);
+  }
+
+  // At least the number of primes in [leftLim, rightLim).
+  static inline std::uint64_t maxPrimesBetween(
+    const std::uint64_t leftLim, const std::uint64_t rightLim)
+  {
+    if (rightLim <= leftLim) {
+      return 0;
+    }
+    const std::uint64_t below =
+      leftLim > 0 ? minPrimesUpTo(leftLim - 1) : 0;
+    return std::min(maxPrimesInSpan(rightLim - leftLim),
+                    maxPrimesUpTo(rightLim - 1) - below);
+  }
+};
+
+}
+
+#endif
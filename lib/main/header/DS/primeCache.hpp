@@ -0,0 +1,120 @@
+//===----------------------------------------------------------===//
+// DS module
+//
+// File purpose: ~primeCache~ class declaration.
+//
+// Description: sieved blocks of the number line, kept in a file
+// that is mapped into memory, so that they outlive the run and are
+// shared by every process that maps the same file. A block is a
+// wheelSegment of kblockBytes bytes (a set bit is a composite
+// number), preceded by the number of primes in it. The file is
+// laid out as
+//
+//   header:  magic "EPRC", version, kblockBytes     (64 bytes)
+//   block i: count, padding                         (64 bytes)
+//            bitmap of [i * blockSpan(), (i + 1) * blockSpan())
+//
+// The count is stored plus one, so that a count of 0 means the block
+// has not been sieved yet. The file grows as blocks further to the
+// right are needed, and the blocks skipped in between are holes,
+// which take no room on the disk.
+//
+// Blocks are sieved apart from the file and copied in whole, under
+// a lock on the file, and only if no one has stored them since, so
+// a block that is present is complete and never written again.
+// Processes that find the same gap sieve it twice, but the first
+// one to finish is the one that stores it.
+//===----------------------------------------------------------===//
+
+#ifndef PRIMECACHE_H
+#define PRIMECACHE_H
+
+#include "DS/wheelSegment.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace DS {
+
+class primeCache {
+public:
+  static constexpr std::size_t kblockBytes = 1 << 16;
+  // Blocks past this one are never stored, which keeps the file
+  // under about a terabyte.
+  static constexpr std::uint64_t kmaxBlocks = 1 << 24;
+
+  // Opens the cache at ~path~, creating it if needed.
+  explicit primeCache(const std::string& path) noexcept(false);
+  ~primeCache();
+
+  primeCache(const primeCache&) = delete;
+  primeCache& operator=(const primeCache&) = delete;
+
+  // Numbers covered by each block.
+  static inline std::uint64_t blockSpan()
+  {
+    return static_cast<std::uint64_t>(wheelSegment::kwheelSz)
+      * kblockBytes;
+  }
+
+  // Numbers below this may be cached.
+  static inline std::uint64_t limit()
+  {
+    return kmaxBlocks * blockSpan();
+  }
+
+  // Grows the file to hold at least the first ~numBlocks~ blocks,
+  // if it does not already, and maps all of it. Blocks stored since
+  // by other processes become visible as well.
+  void reserve(const std::uint64_t numBlocks) noexcept(false);
+
+  // Blocks past the ones reserved are never present.
+  bool hasBlock(const std::uint64_t blockIdx) const;
+
+  // Number of primes in a block that is present, not counting the
+  // wheel primes 2, 3 and 5.
+  std::uint32_t getCount(const std::uint64_t blockIdx) const;
+
+  // Copies a block that is present into ~segment~, which must be
+  // kblockBytes long.
+  void load(const std::uint64_t blockIdx, wheelSegment* segment) const;
+
+  // Stores ~block~, which must be kblockBytes long, as a reserved
+  // block with ~count~ primes, unless it is present already.
+  void store(const std::uint64_t blockIdx, const wheelSegment& block,
+             const std::uint32_t count);
+
+private:
+  static constexpr char kmagic[4] = {'E', 'P', 'R', 'C'};
+  static constexpr std::uint32_t kversion = 1;
+  static constexpr std::size_t kheaderBytes = 64;
+
+  static inline std::uint64_t getRecordBytes()
+  {
+    return kheaderBytes + kblockBytes;
+  }
+
+  std::string path;
+  int fd;
+  std::uint8_t* mapping;
+  // Bytes of the file that are mapped.
+  std::uint64_t mappedBytes;
+
+  inline std::uint64_t getNumBlocks() const
+  {
+    return (mappedBytes - kheaderBytes) / getRecordBytes();
+  }
+
+  inline std::uint8_t* getRecord(const std::uint64_t blockIdx) const
+  {
+    return mapping + kheaderBytes + blockIdx * getRecordBytes();
+  }
+
+  void map() noexcept(false);
+  void unmap();
+};
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+//===----------------------------------------------------------===//
+// DS module
+//
+// File purpose: ~tupletPattern~ class declaration.
+//
+// Description: a prime constellation (twins, triplets, ...), laid
+// out over the bits of a wheelSegment. A form of the constellation
+// is the offsets of its numbers from the first one, e.g. {0, 2, 6}.
+// For each residue modulo the wheel that a form may start at, the
+// other numbers of the form are always the same number of bits
+// further on, so all of the tuplets that start at that residue in
+// a word of primes are found at once, by AND-ing the word with
+// itself shifted by each of those distances.
+//===----------------------------------------------------------===//
+
+#ifndef TUPLETPATTERN_H
+#define TUPLETPATTERN_H
+
+#include <cstdint>
+#include <vector>
+
+namespace DS {
+
+class tupletPattern {
+public:
+  // Most numbers a form may have.
+  static constexpr unsigned kmaxNumbers = 8;
+
+  // No form at all: findStarts never finds anything.
+  tupletPattern();
+  // Every form starts at 0, and is increasing. Only the starts
+  // coprime to the wheel are looked at, so forms holding 2, 3 or 5
+  // have to be found some other way.
+  explicit tupletPattern(
+    const std::vector<std::vector<unsigned>>& forms) noexcept(false);
+
+  inline bool empty() const
+  {
+    return shapes.empty();
+  }
+
+  // Largest offset of any form, i.e. how far past its first number
+  // a tuplet may go.
+  inline unsigned span() const
+  {
+    return maxOffset;
+  }
+
+  // Bits of ~primes~ at which a tuplet starts. A bit of ~primes~ is
+  // set if its number is prime, in the layout of wheelSegment, and
+  // ~next~ holds the 64 bits that come right after it.
+  inline std::uint64_t findStarts(const std::uint64_t primes,
+                                  const std::uint64_t next) const
+  {
+    std::uint64_t starts = 0;
+    for (const shape& s : shapes) {
+      std::uint64_t found = primes & s.startMask;
+      for (unsigned i = 0; i < s.numShifts && found != 0; ++i) {
+        const unsigned shift = s.shifts[i];
+        found &= primes >> shift | next << (64 - shift);
+      }
+      starts |= found;
+    }
+    return starts;
+  }
+
+private:
+  // A form starting at one of the residues of the wheel.
+  struct shape {
+    // Bits of that residue, in every byte of a word.
+    std::uint64_t startMask;
+    // Distance, in bits, from the first number to each other one.
+    std::uint8_t shifts[kmaxNumbers - 1];
+    unsigned numShifts;
+  };
+
+  std::vector<shape> shapes;
+  unsigned maxOffset;
+};
+
+}
+
+#endif
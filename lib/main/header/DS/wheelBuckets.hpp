@@ -0,0 +1,275 @@
+//===----------------------------------------------------------===//
+// DS module
+//
+// File purpose: ~wheelBuckets~ class declaration and definition.
+//
+// Description: buckets of large sieving primes, as in the segmented
+// sieve of Oliveira e Silva. A prime that is larger than a segment
+// hits it a few times at most, if at all, so looking for its
+// multiples in every segment is mostly wasted work. Instead, each
+// prime waits in the bucket of the segment that holds its next
+// multiple. Sieving a segment then only goes through its own
+// bucket, and sends every prime found there to the bucket of the
+// segment it hits next.
+//
+// Buckets are kept in a ring, since a prime never jumps more than
+// a few segments ahead. A bucket is a chain of fixed blocks of
+// entries, all of them taken from a pool that startRun sizes for
+// the whole run, so marking the segments never allocates memory.
+//===----------------------------------------------------------===//
+
+#ifndef WHEELBUCKETS_H
+#define WHEELBUCKETS_H
+
+#include "DS/pageArena.hpp"
+#include "DS/wheelSegment.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace DS {
+
+template <typename primeType>
+class wheelBuckets {
+public:
+  wheelBuckets()
+    : freeBlocks(knoBlock), primes(nullptr), numPrimes(0),
+      numPlaced(0), segSpan(0), runLeftLim(0), curSeg(0), ringSz(0),
+      running(false)
+  {}
+
+  // Whether the segment starting at ~leftLim~ is the next one of the
+  // current run.
+  inline bool continuesRun(const primeType leftLim) const
+  {
+    return running && leftLim == runLeftLim + curSeg * segSpan;
+  }
+
+  // Drops the current run. Has to be called whenever the primes given
+  // to startRun may be gone.
+  inline void stopRun()
+  {
+    running = false;
+  }
+
+  // Starts a run of consecutive segments of ~segSpan~ numbers, the
+  // first of them at ~leftLim~, a multiple of the wheel size.
+  // ~primes~ is sorted, and every one of them is greater than the
+  // number of bytes of a segment. They must outlive the run.
+  void startRun(const primeType* primes, const std::size_t numPrimes,
+                const primeType leftLim, const primeType segSpan)
+    noexcept(false)
+  {
+    if (numPrimes > 0 && primes[numPrimes - 1] >
+        std::numeric_limits<std::uint32_t>::max()) {
+      throw std::overflow_error{
+        "Sieving prime too large for a bucket: " +
+          std::to_string(primes[numPrimes - 1])};
+    }
+    if (segSpan / wheelSegment::kwheelSz > kmaxSegBytes) {
+      throw std::overflow_error{
+        "Segment too large for the buckets: " +
+          std::to_string(segSpan)};
+    }
+
+    this->primes = primes;
+    this->numPrimes = numPrimes;
+    this->segSpan = segSpan;
+    runLeftLim = leftLim;
+    curSeg = 0;
+    running = true;
+
+    // The next multiple of a prime is less than ~6 * prime~ ahead,
+    // and the first one we place less than ~7 * prime~.
+    ringSz = numPrimes > 0 ?
+      7 * primes[numPrimes - 1] / segSpan + 2 : 1;
+    if (ring.size() < ringSz) {
+      ring.resize(ringSz);
+    }
+    for (std::size_t i = 0; i < ringSz; ++i) {
+      ring[i] = bucket{knoBlock, knoBlock, kblockEntries};
+    }
+
+    // Every bucket but one has a block at most partly filled, and the
+    // bucket being marked holds on to its block while the entries in
+    // it move on.
+    const std::size_t numBlocks = numPrimes / kblockEntries + ringSz + 2;
+    if (numBlocks >= knoBlock) {
+      throw std::overflow_error{
+        "Too many sieving primes for the buckets: " +
+          std::to_string(numPrimes)};
+    }
+    blocks.reserve(numBlocks * kblockEntries * sizeof(entry));
+    if (nextBlock.size() < numBlocks) {
+      nextBlock.resize(numBlocks);
+    }
+    for (std::size_t i = 0; i + 1 < numBlocks; ++i) {
+      nextBlock[i] = i + 1;
+    }
+    nextBlock[numBlocks - 1] = knoBlock;
+    freeBlocks = 0;
+
+    // Primes whose square is behind us already have multiples all
+    // around. The others wait until their square shows up.
+    for (numPlaced = 0; numPlaced < numPrimes; ++numPlaced) {
+      const primeType prime = primes[numPlaced];
+      if (prime * prime >= leftLim) {
+        break;
+      }
+      place(prime, wheelSegment::nextCoprime(
+              (leftLim + prime - 1) / prime));
+    }
+  }
+
+  // Marks, in ~segment~, the multiples of the primes of the run. It
+  // must be the segment that continuesRun expects.
+  void markSegment(wheelSegment& segment)
+  {
+    const primeType segRightLim = runLeftLim + (curSeg + 1) * segSpan;
+    for (; numPlaced < numPrimes; ++numPlaced) {
+      const primeType prime = primes[numPlaced];
+      if (prime * prime >= segRightLim) {
+        break;
+      }
+      place(prime, prime);
+    }
+
+    // Primes never move to their own bucket, so it can be taken out
+    // of the ring while its blocks are gone through.
+    bucket& ringBucket = ring[curSeg % ringSz];
+    const bucket cur = ringBucket;
+    ringBucket = bucket{knoBlock, knoBlock, kblockEntries};
+
+    std::uint8_t* const bytes = segment.data();
+    const std::size_t segBytes = segment.numBytes();
+    for (std::uint32_t block = cur.first; block != knoBlock;) {
+      const entry* e = getBlock(block);
+      const entry* const blockEnd =
+        e + (block == cur.last ? cur.lastSz : kblockEntries);
+      for (; e != blockEnd; ++e) {
+        const std::size_t primeBytes =
+          e->prime / wheelSegment::kwheelSz;
+        const wheelSegment::wheelStep* const steps =
+          wheelSegment::kwheelSteps[wheelSegment::residueIdx(e->prime)];
+        std::size_t pos = e->posAndIdx / wheelSegment::knumResidues;
+        unsigned mulIdx = e->posAndIdx % wheelSegment::knumResidues;
+
+        do {
+          const wheelSegment::wheelStep& step = steps[mulIdx];
+          bytes[pos] |= step.mask;
+          pos += primeBytes * step.gap + step.carry;
+          mulIdx = (mulIdx + 1) % wheelSegment::knumResidues;
+        } while (pos < segBytes);
+
+        push((curSeg + pos / segBytes) % ringSz,
+             entry{e->prime, static_cast<std::uint32_t>(
+                 pos % segBytes * wheelSegment::knumResidues
+                 + mulIdx)});
+      }
+
+      const std::uint32_t next = nextBlock[block];
+      nextBlock[block] = freeBlocks;
+      freeBlocks = block;
+      block = next;
+    }
+
+    ++curSeg;
+  }
+
+private:
+  // Primes are below 2^32 as long as the numbers sieved are below
+  // 2^64, so an entry fits in 8 bytes.
+  struct entry {
+    std::uint32_t prime;
+    // Byte of the next multiple in its segment, and index of its
+    // multiplier in wheelSegment's residues.
+    std::uint32_t posAndIdx;
+  };
+
+  static constexpr std::size_t kmaxSegBytes =
+    std::numeric_limits<std::uint32_t>::max()
+    / wheelSegment::knumResidues;
+
+  // Entries per block of a bucket, and the index of no block.
+  static constexpr std::uint32_t kblockEntries = 512;
+  static constexpr std::uint32_t knoBlock =
+    std::numeric_limits<std::uint32_t>::max();
+
+  // First and last blocks of a bucket, and how many entries the last
+  // one holds. An empty bucket has no blocks, and a full last one so
+  // that the next entry starts a new block.
+  struct bucket {
+    std::uint32_t first;
+    std::uint32_t last;
+    std::uint32_t lastSz;
+  };
+
+  std::vector<bucket> ring;
+  // Entries of all the blocks, the block after each one in its
+  // bucket, and the first of the blocks not in use, chained the same
+  // way.
+  pageArena blocks;
+  std::vector<std::uint32_t> nextBlock;
+  std::uint32_t freeBlocks;
+
+  // Primes of the run, and how many of them are in the ring.
+  const primeType* primes;
+  std::size_t numPrimes;
+  std::size_t numPlaced;
+
+  primeType segSpan;
+  primeType runLeftLim;
+  // Index of the next segment in the run.
+  std::size_t curSeg;
+  std::size_t ringSz;
+  bool running;
+
+  // Puts ~prime~ in the bucket of the segment of ~prime * mul~, which
+  // must not be behind the current segment. ~mul~ is coprime to the
+  // wheel.
+  inline void place(const primeType prime, const primeType mul)
+  {
+    const primeType offset = prime * mul - runLeftLim;
+    const primeType seg = offset / segSpan;
+    push(seg % ringSz,
+         entry{static_cast<std::uint32_t>(prime),
+               static_cast<std::uint32_t>(
+                 (offset - seg * segSpan) / wheelSegment::kwheelSz
+                 * wheelSegment::knumResidues
+                 + wheelSegment::residueIdx(mul))});
+  }
+
+  inline entry* getBlock(const std::uint32_t block) const
+  {
+    return static_cast<entry*>(blocks.data()) + block * kblockEntries;
+  }
+
+  // Adds ~e~ to the bucket at ~ringIdx~, taking a new block from the
+  // pool if its last one is full.
+  inline void push(const std::size_t ringIdx, const entry e)
+  {
+    bucket& b = ring[ringIdx];
+    if (b.lastSz == kblockEntries) {
+      const std::uint32_t block = freeBlocks;
+      freeBlocks = nextBlock[block];
+      nextBlock[block] = knoBlock;
+      if (b.last == knoBlock) {
+        b.first = block;
+      }
+      else {
+        nextBlock[b.last] = block;
+      }
+      b.last = block;
+      b.lastSz = 0;
+    }
+    getBlock(b.last)[b.lastSz++] = e;
+  }
+};
+
+}
+
+#endif
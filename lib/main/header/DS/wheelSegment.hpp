@@ -0,0 +1,318 @@
+//===----------------------------------------------------------===//
+// DS module
+//
+// File purpose: ~wheelSegment~ class declaration.
+//
+// Description: a segment of the number line that only stores the
+// numbers coprime to the wheel 2 * 3 * 5 = 30. Every byte holds the
+// 8 candidates of a block of 30 consecutive integers, so one byte
+// covers 30 numbers instead of 8. A set bit means the number is
+// marked (i.e. known to be composite).
+//===----------------------------------------------------------===//
+
+#ifndef WHEELSEGMENT_H
+#define WHEELSEGMENT_H
+
+#include "DS/tupletPattern.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "wheelSegment expects a little-endian target"
+#endif
+
+namespace DS {
+
+class wheelSegment {
+public:
+  static constexpr unsigned kwheelSz = 30;
+  static constexpr unsigned knumResidues = 8;
+
+  // Moving from the multiple ~prime * m~ to the next multiple of
+  // ~prime~ that is coprime to the wheel.
+  struct wheelStep {
+    // How much m grows.
+    std::uint8_t gap;
+    // Bytes crossed on top of ~prime / kwheelSz * gap~.
+    std::uint8_t carry;
+    // Bit of the current multiple inside its byte.
+    std::uint8_t mask;
+  };
+
+  // Primes whose multiples are copied by presieve instead of being
+  // marked one by one.
+  static constexpr unsigned knumPresievePrimes = 5;
+  static const std::uint8_t kpresievePrimes[knumPresievePrimes];
+
+  // kwheelSteps[i][j] is the step of a prime congruent to
+  // kresidues[i], from a multiplier congruent to kresidues[j].
+  static const wheelStep kwheelSteps[knumResidues][knumResidues];
+
+  // Creates a segment of ~numBytes~ blocks, all unmarked.
+  explicit wheelSegment(const std::size_t numBytes)
+    : words((numBytes + sizeof(std::uint64_t) - 1)
+            / sizeof(std::uint64_t), 0),
+      segBytes(numBytes)
+  {}
+
+  // Number of integers covered by the segment (coprime to the wheel
+  // or not).
+  inline std::uint64_t span() const
+  {
+    return static_cast<std::uint64_t>(kwheelSz) * segBytes;
+  }
+
+  inline std::size_t numBits() const
+  {
+    return knumResidues * segBytes;
+  }
+
+  inline std::size_t numBytes() const
+  {
+    return segBytes;
+  }
+
+  inline std::uint8_t* data()
+  {
+    return reinterpret_cast<std::uint8_t*>(words.data());
+  }
+
+  inline const std::uint8_t* data() const
+  {
+    return reinterpret_cast<const std::uint8_t*>(words.data());
+  }
+
+  inline void reset()
+  {
+    std::fill(words.begin(), words.end(), 0);
+  }
+
+  // Leaves marked exactly the multiples of kpresievePrimes, for the
+  // segment starting at ~leftLim~, a multiple of kwheelSz. The
+  // presieve primes themselves stay unmarked.
+  void presieve(const std::uint64_t leftLim);
+
+  inline bool isMarked(const std::size_t bit) const
+  {
+    return (words[bit / kwordBits] >> (bit % kwordBits)) & 1;
+  }
+
+  inline void mark(const std::size_t bit)
+  {
+    words[bit / kwordBits] |= std::uint64_t{1} << (bit % kwordBits);
+  }
+
+  inline void flip(const std::size_t bit)
+  {
+    words[bit / kwordBits] ^= std::uint64_t{1} << (bit % kwordBits);
+  }
+
+  // Marks what is unmarked, and the other way around.
+  inline void flipAll()
+  {
+    for (std::uint64_t& word : words) {
+      word = ~word;
+    }
+  }
+
+  // First unmarked bit not lesser than ~bit~, or numBits() if there
+  // is none.
+  inline std::size_t findUnmarked(const std::size_t bit) const
+  {
+    if (bit >= numBits()) {
+      return numBits();
+    }
+
+    std::size_t wordIdx = bit / kwordBits;
+    std::uint64_t unmarked =
+      ~words[wordIdx] & (~std::uint64_t{0} << (bit % kwordBits));
+    while (unmarked == 0) {
+      if (++wordIdx == words.size()) {
+        return numBits();
+      }
+      unmarked = ~words[wordIdx];
+    }
+
+    const std::size_t found =
+      wordIdx * kwordBits + __builtin_ctzll(unmarked);
+    return found < numBits() ? found : numBits();
+  }
+
+  // Appends to ~out~ the numbers of the unmarked bits in
+  // [firstBit, lastBit), for a segment starting at ~leftLim~.
+  // Returns how many were appended. Only the unmarked bits cost
+  // anything, apart from one load per word.
+  template <typename numType>
+  std::size_t appendUnmarked(const std::size_t firstBit,
+                             const std::size_t lastBit,
+                             const std::uint64_t leftLim,
+                             std::vector<numType>* out) const
+  {
+    if (firstBit >= lastBit) {
+      return 0;
+    }
+
+    const std::size_t oldSz = out->size();
+    const std::size_t firstWord = firstBit / kwordBits;
+    const std::size_t lastWord = (lastBit - 1) / kwordBits;
+    for (std::size_t wordIdx = firstWord; wordIdx <= lastWord;
+         ++wordIdx) {
+      std::uint64_t unmarked = ~words[wordIdx];
+      if (wordIdx == firstWord) {
+        unmarked &= ~std::uint64_t{0} << (firstBit % kwordBits);
+      }
+      if (wordIdx == lastWord) {
+        unmarked &= ~std::uint64_t{0}
+          >> (kwordBits - 1 - (lastBit - 1) % kwordBits);
+      }
+
+      // Each word covers 8 whole blocks of the wheel.
+      const std::uint64_t wordLeftLim = leftLim +
+        static_cast<std::uint64_t>(kwheelSz) * sizeof(std::uint64_t)
+        * wordIdx;
+      for (; unmarked != 0; unmarked &= unmarked - 1) {
+        out->push_back(wordLeftLim +
+                       bitToOffset(__builtin_ctzll(unmarked)));
+      }
+    }
+
+    return out->size() - oldSz;
+  }
+
+  // Appends to ~out~ the first number of each tuplet of ~pattern~
+  // that starts at an unmarked bit of [firstBit, lastBit), and whose
+  // other numbers are all unmarked bits lesser than ~endBit~, for a
+  // segment starting at ~leftLim~. ~endBit~ is at most numBits().
+  // If ~out~ is null, they are only counted. Returns how many there
+  // are.
+  template <typename numType>
+  std::size_t findTuplets(const tupletPattern& pattern,
+                          const std::size_t firstBit,
+                          const std::size_t lastBit,
+                          const std::size_t endBit,
+                          const std::uint64_t leftLim,
+                          std::vector<numType>* out) const
+  {
+    if (firstBit >= lastBit) {
+      return 0;
+    }
+
+    std::size_t numFound = 0;
+    const std::size_t firstWord = firstBit / kwordBits;
+    const std::size_t lastWord = (lastBit - 1) / kwordBits;
+    std::uint64_t primes = getUnmarked(firstWord, endBit);
+    for (std::size_t wordIdx = firstWord; wordIdx <= lastWord;
+         ++wordIdx) {
+      const std::uint64_t next = getUnmarked(wordIdx + 1, endBit);
+      std::uint64_t starts = pattern.findStarts(primes, next);
+      primes = next;
+      if (wordIdx == firstWord) {
+        starts &= ~std::uint64_t{0} << (firstBit % kwordBits);
+      }
+      if (wordIdx == lastWord) {
+        starts &= ~std::uint64_t{0}
+          >> (kwordBits - 1 - (lastBit - 1) % kwordBits);
+      }
+
+      numFound += __builtin_popcountll(starts);
+      if (out) {
+        const std::uint64_t wordLeftLim = leftLim +
+          static_cast<std::uint64_t>(kwheelSz) * sizeof(std::uint64_t)
+          * wordIdx;
+        for (; starts != 0; starts &= starts - 1) {
+          out->push_back(wordLeftLim +
+                         bitToOffset(__builtin_ctzll(starts)));
+        }
+      }
+    }
+
+    return numFound;
+  }
+
+  // Bits of byte ~byteIdx~ that are unmarked and lesser than
+  // ~endBit~, which is at most numBits().
+  inline std::uint8_t getUnmarkedByte(const std::size_t byteIdx,
+                                      const std::size_t endBit) const
+  {
+    return static_cast<std::uint8_t>(
+      getUnmarked(byteIdx / sizeof(std::uint64_t), endBit)
+      >> (byteIdx % sizeof(std::uint64_t) * knumResidues));
+  }
+
+  // Offset, relative to the left limit of the segment, of the number
+  // represented by ~bit~.
+  static inline std::uint64_t bitToOffset(const std::size_t bit)
+  {
+    return static_cast<std::uint64_t>(kwheelSz) * (bit / knumResidues)
+      + kresidues[bit % knumResidues];
+  }
+
+  // First bit whose number is at an offset greater or equal to
+  // ~offset~.
+  static inline std::size_t offsetToBit(const std::uint64_t offset)
+  {
+    return knumResidues * (offset / kwheelSz)
+      + kresidueRank[offset % kwheelSz];
+  }
+
+  // Index in kresidues of ~n % kwheelSz~. ~n~ must be coprime to
+  // the wheel.
+  static inline unsigned residueIdx(const std::uint64_t n)
+  {
+    return kresidueRank[n % kwheelSz];
+  }
+
+  // Smallest number not lesser than ~n~ that is coprime to the
+  // wheel.
+  static inline std::uint64_t nextCoprime(const std::uint64_t n)
+  {
+    return n - n % kwheelSz + kresidues[kresidueRank[n % kwheelSz]];
+  }
+
+  // Number of unmarked bits in [firstBit, lastBit).
+  std::size_t countUnmarked(const std::size_t firstBit,
+                            const std::size_t lastBit) const;
+
+  // Marks every multiple ~prime * m~ that falls inside the segment
+  // starting at ~leftLim~, where ~m >= prime~ and ~m~ is coprime to
+  // the wheel. ~leftLim~ has to be a multiple of kwheelSz, and
+  // ~prime~ must not divide kwheelSz.
+  void markMultiples(const std::uint64_t prime,
+                     const std::uint64_t leftLim);
+
+private:
+  static constexpr unsigned kwordBits = 64;
+
+  // Bit ~i~ of byte ~j~ is bit ~8 * j + i~ of the buffer, which is
+  // what a little-endian load of the words gives. The last word may
+  // have some bytes past segBytes, which are never looked at.
+  std::vector<std::uint64_t> words;
+  std::size_t segBytes;
+
+  // Bits of word ~wordIdx~ that are unmarked and lesser than
+  // ~endBit~. The word may lie past the end of the segment.
+  inline std::uint64_t getUnmarked(const std::size_t wordIdx,
+                                   const std::size_t endBit) const
+  {
+    const std::size_t wordFirstBit = wordIdx * kwordBits;
+    if (wordFirstBit >= endBit) {
+      return 0;
+    }
+    const std::uint64_t unmarked = ~words[wordIdx];
+    return endBit - wordFirstBit >= kwordBits ? unmarked :
+      unmarked & ((std::uint64_t{1} << (endBit - wordFirstBit)) - 1);
+  }
+
+  // The 8 residues modulo 30 that are coprime to 30.
+  static const std::uint8_t kresidues[knumResidues];
+  // For each residue modulo 30, the index of the first element of
+  // kresidues that is greater or equal to it.
+  static const std::uint8_t kresidueRank[kwheelSz];
+};
+
+}
+
+#endif
@@ -9,5 +9,9 @@
 #define INTERFACE_H
 
 #include "init.hpp"
+#include "library.hpp"
+#include "outputSink.hpp"
+#include "primeIterator.hpp"
+#include "tuneFile.hpp"
 
 #endif
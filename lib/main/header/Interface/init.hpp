@@ -10,13 +10,21 @@
 #ifndef INIT_H
 #define INIT_H
 
+#include "Alg/asyncSink.hpp"
 #include "Alg/eratSieve.hpp"
+#include "Alg/primeSink.hpp"
+#include "Alg/sieveConfig.hpp"
 #include "DS/array.hpp"
+#include "Interface/tuneFile.hpp"
 #include "Utils/defs.hpp"
 #include "Utils/hwInfo.hpp"
+#include "Utils/primeFile.hpp"
 #include "Utils/time.hpp"
 
+#include <cstdint>
 #include <fstream>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "mpi.h"
@@ -34,59 +42,156 @@ private:
   // See ~validateArguments~ for details on how program arguments
   // are validated.
   const int knumProgArgs = 3;
-  const int kminRightLim = 2;
-  const int kmaxRightLim = 1e9;
+  const primeT kminRightLim = 2;
+  const primeT kmaxRightLim = 10000000000000000000ULL; // 1e19
+  const unsigned kminThreads = 1;
+  const unsigned kmaxThreads = 1024;
+  const std::size_t kminWindowBytes = tuneFile::kminWindowBytes;
+  const std::size_t kmaxWindowBytes = tuneFile::kmaxWindowBytes;
+  const char* const kdefaultTunePath = "eratosthenes-sieve.tune";
+  // Host names are sent around in buffers of this size.
+  static constexpr unsigned kmaxHostNameLen = 256;
 
   // MPI variables
   int myProcRank;
   int commSz;
 
   // Program entries
-  int arrRightLim;
-  char outMode;
+  primeT arrLeftLim;
+  primeT arrRightLim;
+  std::string outMode;
+  // File with the window size of each host.
+  std::string tunePath;
+  // Width of the range timed by the autotuner. 0 means no tuning.
+  primeT autotuneSpan;
+  // Where the list goes (standard output if empty), and how.
+  std::string outPath;
+  bool binaryOutput;
+  Utils::primeFile::format outFormat;
+  // File of sieved blocks kept between runs. Empty means none.
+  std::string cachePath;
+  // Where the profile of the run goes. Empty means no profiling.
+  std::string profilePath;
+  // Index of the prime looked for, in n mode.
+  std::uint64_t nthIndex;
 
   // processEntries build this object for the algorithm.
   Utils::cacheInfo cinfo;
+  // Filled according to the program options.
+  Alg::sieveConfig sconfig;
 
   //===--------------------------------------------------------===//
   // Procedures
   //===--------------------------------------------------------===//
   void setMPIVariables();
-  void allocatePrimesList();
 
   // Performs some basic validation on the program arguments.
   //
-  // Program should receive exactly two arguments:
+  // Program should receive at least two arguments:
   //
   // - The right limit (~n~) for the vector of numbers we will
-  // create (limit goes from [2, n]). 2 <= n <= 1e9
+  // create (limit goes from [2, n]). 2 <= n <= 1e19
   //
-  // - The mode of output:
+  // - The mode of output, made of one or more of the letters:
   //
   //   - l: print list of primes until n.
   //   - t: print time of execution (6 decimal places).
   //   - a: all (l and t)
+  //   - c: print the number of primes until n. Without l, the list
+  //     of primes is never built.
+  //   - n: print the n-th prime instead, where n is its index
+  //     (p_1 = 2). 1 <= n <= pi(1e19). Can only go along with t,
+  //     and no left limit may be given.
+  //
+  // These may be followed by options, in the form --<name>=<value>:
+  //
+  // - --threads=<n>: number of threads used by each process.
+  //   1 <= n <= 1024
+  // - --left-limit=<m>: only look for primes in [m, n]. 0 <= m <= n
+  // - --window-bytes=<b>: size of the window each thread sieves in.
+  //   1 <= b <= 2^28. Overrides the tune file.
+  // - --autotune=<w>: before sieving, time a few window sizes on the
+  //   last w numbers of the range, and save the best one for this
+  //   host in the tune file. 1 <= w
+  // - --tune-file=<path>: where window sizes are loaded from, and
+  //   saved to. Defaults to kdefaultTunePath.
+  // - --format=<f>: how the list is written. One of text (the
+  //   default), varint or bitmap. See Utils::primeFile.
+  // - --output=<path>: write the list to ~path~ instead of the
+  //   standard output. If ~path~ has a %r in it, each process writes
+  //   the primes of its own slab to ~path~, with %r replaced by its
+  //   rank.
+  // - --counter=<c>: how c and n count primes. One of auto (the
+  //   default), sieve or lmo. See Alg::primeCounter.
+  // - --cache=<path>: look l and c up in the cache of sieved blocks
+  //   at ~path~, created if needed, and add to it what is missing.
+  //   See DS::primeCache. Takes the place of the counter, is not used
+  //   by n, and does not go along with %r in the output path.
+  // - --profile=<path>: time the phases of the sieve in every
+  //   process, with hardware counters if the system allows it, and
+  //   write their minimum, average and maximum over the processes to
+  //   ~path~, as JSON. See Utils::profiler.
+  // - --schedule=<s>: how the range is split between the processes.
+  //   One of even (the default), where each gets a slab of the same
+  //   width, or guided, where they claim chunks as they go. See
+  //   Alg::eratSieve. Output by rank is always split evenly.
+  // - --gather=<g>: how the listed primes of an even schedule reach
+  //   the root. One of pipelined (the default), batch by batch while
+  //   the processes sieve, or round, all of a round at once.
+  // - --tuplets=<k>: l and c give the prime tuplets of kind k whose
+  //   numbers all lie in [m, n] instead of the primes, each one by
+  //   its first prime. One of twins, cousins, triplets or
+  //   quadruplets. See Alg::tupletKind. Does not go along with n or
+  //   --cache.
+  // - --engine=<e>: what sieves the windows. One of auto (the
+  //   default), which picks one by the range, or the name of an
+  //   engine: eratosthenes or atkin. See Alg::sieveEngine. lmo counts
+  //   use it for their sieving too.
   void setAndValidateArguments(int argc, char** argv)
     noexcept(false);
+  void setOption(const char* arg) noexcept(false);
 
   // No validation is needed here. Just build the entry array.
   void processEntries(int argc, char** argv) noexcept(false);
 
+  // Runs the algorithm the mode asks for.
+  void run() noexcept(false);
+
+  // Writes the profile of the run to profilePath, in the root
+  // process. Every process has to call it.
+  void writeProfile() noexcept(false);
+
+  // Sets up listSink, in the processes that write primes.
+  void openOutput() noexcept(false);
+
+  // Picks the window size of each host with Alg::segmentTuner, and
+  // has the root process save them.
+  void autotune() noexcept(false);
+
   //===--------------------------------------------------------===//
   // Output stuff
   //===--------------------------------------------------------===//
   // Decided according to outMode in processEntries
   bool shouldPrintList;
   bool shouldPrintTime;
+  bool shouldPrintCount;
+  bool shouldPrintNth;
   std::chrono::duration<double> clkVar;
 
-  // We pass this as an argument to the algorithm, and let it take
-  // care of the rest.
-  std::vector<primeT>* primesList;
-
-  // Prints output, according to outMode
+  // We pass listSink to the algorithm, which streams the primes to
+  // it as they are found. It writes them to outSink from a thread of
+  // its own.
+  std::ofstream outFile;
+  std::unique_ptr<Alg::primeSink<primeT>> outSink;
+  std::unique_ptr<Alg::asyncSink<primeT>> listSink;
+  std::uint64_t numPrimes;
+  primeT nthPrimeFound;
+
+  // Prints output, according to outMode. The list is already out by
+  // then.
   void printOutput();
-  void printOutList();
+  void printOutCount();
+  void printOutNth();
   void printOutTime();
 };
 
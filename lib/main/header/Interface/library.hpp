@@ -0,0 +1,99 @@
+//===----------------------------------------------------------===//
+// Interface module
+//
+// File purpose: declaration of class ~library~.
+//
+// Description: the entry points for programs that link the sieve
+// in, instead of running it from the command line. Nothing is
+// parsed or printed.
+//
+// By default, everything runs in the calling process alone. Given a
+// communicator, the work is split between its processes instead,
+// and every one of them has to make the same call. If the program
+// has not initialized MPI by the first call, it is initialized
+// then, and finalized at exit.
+//===----------------------------------------------------------===//
+
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+#include "Alg/eratSieve.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mpi.h"
+
+namespace Interface {
+
+struct libraryConfig {
+  // Threads each process sieves with.
+  unsigned numThreads = 1;
+
+  // Size of the window each thread sieves at a time, in bytes. 0
+  // means half of the L1 data cache.
+  std::size_t windowBytes = 0;
+
+  // Engine that sieves the windows. Empty means the one that suits
+  // the range. See Alg::sieveEngine.
+  std::string engine;
+
+  // How countPrimes and nthPrime count. See Alg::primeCounter.
+  Alg::countMethod counter = Alg::countMethod::automatic;
+
+  // How the work is split between the processes of comm.
+  Alg::scheduleMode schedule = Alg::scheduleMode::even;
+
+  // How the primes of generatePrimes reach the root, with an even
+  // schedule.
+  Alg::gatherMode gather = Alg::gatherMode::pipelined;
+
+  // Processes that share the work.
+  MPI_Comm comm = MPI_COMM_SELF;
+
+  // If set, generatePrimes and countPrimes go through the cache of
+  // sieved blocks at this path instead, and add to it what they
+  // sieve. See Alg::cachedSieve.
+  std::string cachePath;
+};
+
+class library {
+public:
+  // Largest number that can be sieved.
+  static constexpr primeT kmaxLimit = 10000000000000000000ULL; // 1e19
+
+  // Appends the primes in [leftLim, rightLim] to ~out~, in order.
+  // With more than one process, only the root (rank 0) of
+  // config.comm gets them. The range is empty if leftLim >
+  // rightLim.
+  static void generatePrimes(const primeT leftLim,
+                             const primeT rightLim,
+                             std::vector<primeT>* out,
+                             const libraryConfig& config =
+                               libraryConfig()) noexcept(false);
+
+  // Number of primes in [leftLim, rightLim], found without sieving
+  // all of it when that is cheaper. Every process of config.comm
+  // gets it.
+  static std::uint64_t countPrimes(const primeT leftLim,
+                                   const primeT rightLim,
+                                   const libraryConfig& config =
+                                     libraryConfig()) noexcept(false);
+
+  // The ~n~-th prime, counting from p_1 = 2, found by counting up
+  // to a bound close below it. Every process of config.comm gets
+  // it. 1 <= n <= Alg::nthPrime::kmaxIndex
+  static primeT nthPrime(const std::uint64_t n,
+                         const libraryConfig& config =
+                           libraryConfig()) noexcept(false);
+
+  // Initializes MPI, unless it already is. Called by everything
+  // above.
+  static void initMPI() noexcept(false);
+};
+
+}
+
+#endif
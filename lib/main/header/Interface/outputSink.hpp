@@ -0,0 +1,57 @@
+//===----------------------------------------------------------===//
+// Interface module
+//
+// File purpose: declaration of the sinks that write the list of
+// primes out, as eratSieve finds them.
+//===----------------------------------------------------------===//
+
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include "Alg/eratSieve.hpp"
+#include "Alg/primeSink.hpp"
+#include "Utils/decimalWriter.hpp"
+#include "Utils/primeFile.hpp"
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Interface {
+
+// Decimal list, separated by spaces, and ended by a new line. It is
+// written to the file at ~path~, or to the standard output if
+// ~path~ is empty, formatted by ~numThreads~ threads.
+class textSink : public Alg::primeSink<primeT> {
+public:
+  textSink(const std::string& path, const unsigned numThreads)
+    noexcept(false);
+
+  void start(const primeT leftLim, const primeT rightLim) override;
+  void consume(std::vector<primeT>& primes) noexcept(false) override;
+  void finish() noexcept(false) override;
+
+private:
+  std::unique_ptr<Utils::decimalWriter> writer;
+};
+
+// One of the formats of Utils::primeFile.
+class binarySink : public Alg::primeSink<primeT> {
+public:
+  binarySink(std::ostream& os, const Utils::primeFile::format fmt);
+
+  void start(const primeT leftLim, const primeT rightLim)
+    noexcept(false) override;
+  void consume(std::vector<primeT>& primes) noexcept(false) override;
+  void finish() noexcept(false) override;
+
+private:
+  std::ostream& os;
+  const Utils::primeFile::format fmt;
+  std::unique_ptr<Utils::primeFile::writer> writer;
+};
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+//===----------------------------------------------------------===//
+// Interface module
+//
+// File purpose: declaration of class ~primeIterator~.
+//
+// Description: walks through the primes in increasing order, from
+// some starting point on, with no upper limit set in advance. The
+// primes are sieved in chunks, as they are needed, in the calling
+// process alone. Chunks grow as the walk goes on, so that finding
+// the sieving primes again for each of them stays cheap.
+//===----------------------------------------------------------===//
+
+#ifndef PRIMEITERATOR_H
+#define PRIMEITERATOR_H
+
+#include "Interface/library.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace Interface {
+
+class primeIterator {
+public:
+  // Starts at the first prime not lesser than ~start~. Only the
+  // threads and the window size of ~config~ are used.
+  explicit primeIterator(const primeT start = 0,
+                         const libraryConfig& config =
+                           libraryConfig()) noexcept(false);
+
+  inline primeT operator*() const
+  {
+    return primes[pos];
+  }
+
+  // Moves to the next prime. Throws std::out_of_range past the last
+  // prime below library::kmaxLimit.
+  inline primeIterator& operator++() noexcept(false)
+  {
+    if (++pos == primes.size()) {
+      nextChunk();
+    }
+    return *this;
+  }
+
+  // The current prime, moving on to the next one.
+  inline primeT next() noexcept(false)
+  {
+    const primeT prime = primes[pos];
+    ++*this;
+    return prime;
+  }
+
+private:
+  // Span of the first chunk, and largest span a chunk gets to from
+  // doubling alone.
+  static constexpr primeT kminChunkSpan = 1 << 16;
+  static constexpr primeT kmaxChunkSpan = 1 << 24;
+  // Chunks span at least this many times the square root of their
+  // left limit, which is about how far the sieving primes go.
+  static constexpr primeT kchunkSqrtFactor = 2;
+
+  libraryConfig config;
+  // Primes of the current chunk, and where we are in it.
+  std::vector<primeT> primes;
+  std::size_t pos;
+  // Left limit of the next chunk.
+  primeT chunkLeftLim;
+  primeT chunkSpan;
+
+  void nextChunk() noexcept(false);
+};
+
+}
+
+#endif
@@ -0,0 +1,48 @@
+//===----------------------------------------------------------===//
+// Interface module
+//
+// File purpose: declaration of class ~tuneFile~.
+//
+// Description: the file where the window size found by the
+// autotuner is kept, for each host. It is plain text, one host per
+// line:
+//
+//   <host-name> <window-bytes>
+//
+// Empty lines and lines starting with '#' are ignored. The window
+// sizes are checked as --window-bytes is.
+//===----------------------------------------------------------===//
+
+#ifndef TUNEFILE_H
+#define TUNEFILE_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+
+namespace Interface {
+
+class tuneFile {
+public:
+  typedef std::map<std::string, std::size_t> entriesT;
+
+  // Window sizes a run may take, from the file or not.
+  static constexpr std::size_t kminWindowBytes = 1;
+  static constexpr std::size_t kmaxWindowBytes = 1 << 28;
+
+  // Every entry of the file at ~path~. A missing file has none.
+  static entriesT read(const std::string& path) noexcept(false);
+
+  // Window size saved for ~host~, or 0 if there is none.
+  static std::size_t lookUp(const std::string& path,
+                            const std::string& host) noexcept(false);
+
+  // Adds ~entries~ to the file at ~path~, replacing the ones of the
+  // same hosts.
+  static void update(const std::string& path, const entriesT& entries)
+    noexcept(false);
+};
+
+}
+
+#endif
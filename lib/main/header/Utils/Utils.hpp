@@ -8,10 +8,16 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include "Utils/decimalWriter.hpp"
 #include "Utils/defs.hpp"
 #include "Utils/error.hpp"
 #include "Utils/hwInfo.hpp"
 #include "Utils/file.hpp"
+#include "Utils/mpiType.hpp"
+#include "Utils/num.hpp"
+#include "Utils/primeFile.hpp"
+#include "Utils/profiler.hpp"
+#include "Utils/threadPool.hpp"
 #include "Utils/time.hpp"
 
 #endif
@@ -0,0 +1,87 @@
+//===----------------------------------------------------------===//
+// Utils module
+//
+// File purpose: declaration of class ~decimalWriter~.
+//
+// Description: writes primes as the decimal list, each one followed
+// by a space, straight to a file descriptor. Numbers are turned into
+// digits two at a time, out of a table of the pairs 00 to 99, and go
+// to the descriptor in buffers of a few megabytes, with no stream in
+// between.
+//
+// Large chunks are split between the threads of a pool, each
+// formatting its part into a buffer of its own. The buffers are then
+// written in order with a single writev.
+//===----------------------------------------------------------===//
+
+#ifndef DECIMALWRITER_H
+#define DECIMALWRITER_H
+
+#include "DS/pageArena.hpp"
+#include "Utils/threadPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Utils {
+
+class decimalWriter {
+public:
+  // Digits of the largest 64-bit number, and the space after it.
+  static constexpr std::size_t kmaxPrimeBytes = 21;
+
+  // Writes to ~fd~, which is left open.
+  decimalWriter(const int fd, const unsigned numThreads)
+    noexcept(false);
+  // Writes to the file at ~path~, created or truncated, and closed
+  // along with the writer.
+  decimalWriter(const std::string& path, const unsigned numThreads)
+    noexcept(false);
+  ~decimalWriter();
+
+  decimalWriter(const decimalWriter&) = delete;
+  decimalWriter& operator=(const decimalWriter&) = delete;
+
+  void append(const std::uint64_t* primes, const std::size_t num)
+    noexcept(false);
+
+  // Appends ~c~, and writes out everything still in the buffers.
+  void finish(const char c) noexcept(false);
+
+  // Writes ~primes~ from ~out~ on, and returns the end of what was
+  // written, which is at most kmaxPrimeBytes per prime.
+  static char* format(const std::uint64_t* primes, const std::size_t num,
+                      char* out);
+
+private:
+  // Size of each buffer.
+  static constexpr std::size_t kbufferBytes = 1 << 22;
+  static constexpr std::size_t kbufferPrimes =
+    kbufferBytes / kmaxPrimeBytes;
+  // Chunks smaller than this are formatted by the calling thread
+  // alone.
+  static constexpr std::size_t kminParallelPrimes = 1 << 16;
+
+  int fd;
+  const bool ownsFd;
+  threadPool pool;
+
+  // Buffer of the calling thread, and how much of it is taken.
+  DS::pageArena buf;
+  std::size_t bufUsed;
+  // Buffers of the threads of the pool, and how much of each one
+  // their last part took.
+  std::vector<DS::pageArena> parts;
+  std::vector<std::size_t> partBytes;
+
+  void init() noexcept(false);
+  void flush() noexcept(false);
+  void writeAll(const char* const* bufs, const std::size_t* sizes,
+                const std::size_t numBufs) noexcept(false);
+};
+
+}
+
+#endif
@@ -14,6 +14,7 @@
 #define INTERFACE_INIT_DEBUG 0
 //#define INTERFACE_INIT_DEBUG_PRINT_GREATER_THAN 900000
 #define ALG_ERATSIEVE_DEBUG 0
+#define ALG_SEGMENTTUNER_DEBUG 0
 
 // MPI macros
 #define SUPER_EXIT(errcode) {MPI_Finalize(); exit(errcode);}
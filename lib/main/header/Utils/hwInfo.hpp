@@ -9,6 +9,7 @@
 #ifndef HWINFO_H
 #define HWINFO_H
 
+#include <string>
 #include <tuple>
 
 namespace Utils {
@@ -49,6 +50,9 @@ public:
   static void fetchCacheInfo(cacheInfo* const destStruct,
                              const unsigned level,
                              const unsigned iOrC);
+
+  // Name of the machine we are running on.
+  static std::string getHostName() noexcept(false);
 };
 
 }
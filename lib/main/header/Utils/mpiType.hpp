@@ -0,0 +1,37 @@
+//===----------------------------------------------------------===//
+// Utils module
+//
+// File purpose: mapping from C++ numeric types to the MPI datatypes
+// used to transfer them.
+//===----------------------------------------------------------===//
+
+#ifndef MPITYPE_H
+#define MPITYPE_H
+
+#include <cstdint>
+
+#include "mpi.h"
+
+namespace Utils {
+
+template <typename numType>
+struct mpiType;
+
+template <>
+struct mpiType<std::uint32_t> {
+  static inline MPI_Datatype get() { return MPI_UINT32_T; }
+};
+
+template <>
+struct mpiType<std::uint64_t> {
+  static inline MPI_Datatype get() { return MPI_UINT64_T; }
+};
+
+template <>
+struct mpiType<double> {
+  static inline MPI_Datatype get() { return MPI_DOUBLE; }
+};
+
+}
+
+#endif
@@ -9,6 +9,8 @@
 #ifndef NUM_H
 #define NUM_H
 
+#include <cmath>
+#include <limits>
 #include <stdexcept>
 #include <string>
 
@@ -37,6 +39,69 @@ public:
   {
     return a > b ? a : b;
   }  
+
+  // n * n, saturated at the largest value numType can hold.
+  static inline numType sqrdSat(const numType n)
+  {
+    if (n != 0 && n > std::numeric_limits<numType>::max() / n) {
+      return std::numeric_limits<numType>::max();
+    }
+    return n * n;
+  }
+
+  // Largest r such that r * r <= n.
+  static inline numType isqrt(const numType n)
+  {
+    numType r = static_cast<numType>(std::sqrt(static_cast<long double>(n)));
+    // Fix the rounding errors of the floating point square root.
+    while (r > 0 && r > n / r) {
+      --r;
+    }
+    while (r + 1 <= n / (r + 1)) {
+      ++r;
+    }
+    return r;
+  }
+
+  // Largest r such that r * r * r <= n.
+  static inline numType icbrt(const numType n)
+  {
+    numType r = static_cast<numType>(std::cbrt(static_cast<long double>(n)));
+    // Fix the rounding errors of the floating point cube root.
+    while (r > 0 && r > n / r / r) {
+      --r;
+    }
+    while (r + 1 <= n / (r + 1) / (r + 1)) {
+      ++r;
+    }
+    return r;
+  }
+
+  // Parses the whole string ~str~ as a non-negative integer, in
+  // decimal notation.
+  static inline numType parseUnsigned(const char* str) noexcept(false)
+  {
+    const std::string s{str};
+    if (s.empty() || s.find_first_not_of("0123456789") != s.npos) {
+      throw std::invalid_argument{
+        '\'' + s + "' is not a non-negative integer"};
+    }
+
+    const std::out_of_range tooLarge{s + " does not fit in " +
+        std::to_string(sizeof(numType) * 8) + " bits"};
+    unsigned long long n = 0;
+    try {
+      n = std::stoull(s);
+    }
+    catch (std::out_of_range&) {
+      throw tooLarge;
+    }
+    if (n > static_cast<unsigned long long>(
+          std::numeric_limits<numType>::max())) {
+      throw tooLarge;
+    }
+    return static_cast<numType>(n);
+  }
 };
 
 }
@@ -0,0 +1,116 @@
+//===----------------------------------------------------------===//
+// Utils module
+//
+// File purpose: declaration of class ~primeFile~.
+//
+// Description: binary files of primes, much smaller and faster to
+// load than the decimal list. Every file starts with a 32-byte
+// header, all fields little-endian:
+//
+//   magic (4 bytes), version (uint32), left limit (uint64),
+//   right limit (uint64, inclusive), number of primes (uint64)
+//
+// The number of primes is kunknownCount if the file was streamed to
+// something that could not be rewound to fill it in.
+//
+// and then comes one of the bodies:
+//
+// - varint ("EPRV"): the gap from each prime to the previous one
+//   (to the left limit, for the first prime), as LEB128 varints.
+//   Most gaps fit in a single byte.
+// - bitmap ("EPRB"): the mod-30 wheel bitmap of [leftLim - leftLim
+//   % 30, rightLim], one byte per 30 numbers, bit i of a byte set if
+//   the number with the i-th residue coprime to 30 is prime. 2, 3
+//   and 5 cannot be stored, so they are implied whenever they lie
+//   inside the limits.
+//===----------------------------------------------------------===//
+
+#ifndef PRIMEFILE_H
+#define PRIMEFILE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Utils {
+
+class primeFile {
+public:
+  enum class format { varint, bitmap };
+
+  struct header {
+    format fmt;
+    std::uint64_t leftLim;
+    std::uint64_t rightLim;
+    std::uint64_t numPrimes;
+  };
+
+  static constexpr std::uint64_t kunknownCount = ~std::uint64_t{0};
+
+  // Writes the primes of [leftLim, rightLim] to a stream as they
+  // come, in increasing order.
+  class writer {
+  public:
+    // Writes the header right away.
+    writer(std::ostream& os, const format fmt,
+           const std::uint64_t leftLim, const std::uint64_t rightLim)
+      noexcept(false);
+
+    void append(const std::uint64_t* primes, const std::size_t num)
+      noexcept(false);
+
+    // Writes what is left of the body, and the number of primes in
+    // the header if ~os~ can seek back to it.
+    void finish() noexcept(false);
+
+  private:
+    std::ostream& os;
+    const format fmt;
+    const std::uint64_t leftLim;
+    const std::uint64_t rightLim;
+    // Where the header starts in ~os~, or -1 if we can not go back.
+    const std::streamoff headerPos;
+    std::uint64_t numPrimes;
+
+    // varint: last prime written.
+    std::uint64_t prev;
+    // bitmap: first number of the wheel byte being filled, how many
+    // bytes there are in all, and how many of them were written.
+    const std::uint64_t base;
+    const std::uint64_t numBytes;
+    std::uint64_t numBytesDone;
+    std::uint8_t curByte;
+
+    std::vector<char> buf;
+
+    void flushBuf() noexcept(false);
+  };
+
+  // Writes ~primes~, the sorted primes of [leftLim, rightLim], to
+  // ~os~ in format ~fmt~.
+  static void write(std::ostream& os, const format fmt,
+                    const std::uint64_t leftLim,
+                    const std::uint64_t rightLim,
+                    const std::vector<std::uint64_t>& primes)
+    noexcept(false);
+
+  // Reads the file at ~path~, in whichever format it is. Fills
+  // ~hdr~ if it is not null.
+  static std::vector<std::uint64_t> read(const std::string& path,
+                                         header* hdr = nullptr)
+    noexcept(false);
+
+  // Parses a format name ("varint" or "bitmap").
+  static format parseFormat(const std::string& name) noexcept(false);
+
+private:
+  static constexpr std::uint32_t kversion = 1;
+  static constexpr std::size_t kheaderSz = 32;
+  static const char kvarintMagic[4];
+  static const char kbitmapMagic[4];
+};
+
+}
+
+#endif
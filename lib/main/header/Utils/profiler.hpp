@@ -0,0 +1,111 @@
+//===----------------------------------------------------------===//
+// Utils module
+//
+// File purpose: declaration of class ~profiler~, and of the
+// PROFILE_SCOPE macro.
+//
+// Description: time spent by each process in the phases of the
+// sieve, so that a slow run can be told to be compute, memory or
+// communication bound. A scope is opened with
+//
+//   PROFILE_SCOPE(profiler::kfirstPass);
+//
+// and whatever runs until the end of the block counts towards the
+// phase. Phases nest, e.g. fuseCurPrimesGlobal is part of
+// markPrimesLocal, and a phase entered more than once adds up.
+//
+// Along with the time, the profiler may read hardware counters
+// (cycles, L1 data cache misses and branch misses) with
+// perf_event_open, if the system lets it. They count the thread that
+// opened the scope, i.e. the main thread: with --threads=1 that is
+// all the work, otherwise the share of thread 0 of the pool.
+//
+// Until enable is called, scopes cost a branch each. Only the main
+// thread of a process may open them.
+//===----------------------------------------------------------===//
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+#include "mpi.h"
+
+namespace Utils {
+
+class profiler {
+public:
+  enum phase {
+    krun,
+    kfirstPass,
+    kfindSievingPrimes,
+    kshareSievingPrimes,
+    kmarkPrimesLocal,
+    kfuseCurPrimesGlobal,
+    koutput,
+    knumPhases
+  };
+
+  enum counter {
+    kcycles,
+    kl1dMisses,
+    kbranchMisses,
+    knumCounters
+  };
+
+  class scope {
+  public:
+    explicit scope(const phase p);
+    ~scope();
+
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+
+  private:
+    const phase p;
+    std::chrono::steady_clock::time_point start;
+    std::uint64_t startCounters[knumCounters];
+  };
+
+  // Starts recording, with the hardware counters if ~withCounters~
+  // and the system allows it.
+  static void enable(const bool withCounters);
+  static inline bool isEnabled()
+  {
+    return enabled;
+  }
+
+  // Writes, in the root process of ~comm~, the minimum, average and
+  // maximum over the processes of every phase, as JSON. Every
+  // process of ~comm~ has to call it.
+  static void report(MPI_Comm comm, std::ostream& out);
+
+private:
+  struct phaseTotals {
+    double seconds = 0;
+    std::uint64_t calls = 0;
+    std::uint64_t counters[knumCounters] = {};
+  };
+
+  static bool enabled;
+  // File descriptor of the group of counters, or -1 without them.
+  static int counterFd;
+  static phaseTotals totals[knumPhases];
+
+  static const char* const kphaseNames[knumPhases];
+  static const char* const kcounterNames[knumCounters];
+
+  static void openCounters();
+  static void readCounters(std::uint64_t* values);
+};
+
+}
+
+#define PROFILE_SCOPE_NAME(line) profileScope##line
+#define PROFILE_SCOPE_AT(p, line)                                \
+  Utils::profiler::scope PROFILE_SCOPE_NAME(line)(p)
+#define PROFILE_SCOPE(p) PROFILE_SCOPE_AT(p, __LINE__)
+
+#endif
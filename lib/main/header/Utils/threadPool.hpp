@@ -0,0 +1,90 @@
+//===----------------------------------------------------------===//
+// Utils module
+//
+// File purpose: declaration of class ~threadPool~.
+//
+// Description: a fixed set of threads that run batches of indexed
+// tasks. Every thread owns a queue of task indices, and once its
+// own queue runs dry it steals from the back of the queues of the
+// other threads. The thread calling ~run~ works as thread 0, so it
+// is the only one that ever has to talk to MPI.
+//
+// Running a batch allocates no memory: the queues are ranges of
+// indices, and the task is only referred to.
+//===----------------------------------------------------------===//
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utils {
+
+class threadPool {
+public:
+  // Receives the index of the thread running it, and the index of
+  // the task.
+  typedef std::function<void(const unsigned, const std::size_t)>
+    taskT;
+
+  // Creates ~numThreads - 1~ worker threads.
+  explicit threadPool(const unsigned numThreads);
+  ~threadPool();
+
+  inline unsigned size() const
+  {
+    return queues.size();
+  }
+
+  // Runs ~task~ for every index in [0, numTasks), and returns when
+  // all of them are done. Each thread starts with a contiguous block
+  // of indices. If some task throws, the first exception caught is
+  // rethrown here, after the batch is over.
+  template <typename taskFn>
+  void run(const std::size_t numTasks, const taskFn& task)
+    noexcept(false)
+  {
+    // A taskT wrapping a reference never allocates, whatever the
+    // task captures.
+    runTasks(numTasks, taskT{std::cref(task)});
+  }
+
+private:
+  // Tasks [first, last) are left in the queue.
+  struct workQueue {
+    std::mutex mtx;
+    std::size_t first;
+    std::size_t last;
+  };
+
+  std::vector<std::unique_ptr<workQueue>> queues;
+  std::vector<std::thread> workers;
+
+  // Everything below is protected by poolMtx.
+  std::mutex poolMtx;
+  std::condition_variable startCv;
+  std::condition_variable doneCv;
+  const taskT* curTask;
+  // Incremented every time a new batch starts.
+  unsigned long generation;
+  unsigned numWorking;
+  bool stopping;
+  std::exception_ptr firstError;
+
+  void runTasks(const std::size_t numTasks, const taskT& task)
+    noexcept(false);
+  void workerLoop(const unsigned threadIdx);
+  void work(const unsigned threadIdx);
+  bool nextTask(const unsigned threadIdx, std::size_t& taskIdx);
+};
+
+}
+
+#endif
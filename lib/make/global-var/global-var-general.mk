@@ -7,7 +7,7 @@
 
 # Compiler command and flags
 CXX   := mpiCC
-FLAGS := -std=c++14 -g -Wextra
+FLAGS := -std=c++14 -g -Wextra -pthread
 
 # Source directory
 SOURCE := lib
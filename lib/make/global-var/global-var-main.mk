@@ -14,3 +14,4 @@ BUILD_MAIN :=
 
 MAIN_FILE = tools/main.cpp
 TARGET = $(BUILD)/eratosthenes-sieve
+LIBRARY = $(BUILD)/liberatosthenes-sieve.a
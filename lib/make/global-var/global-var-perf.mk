@@ -18,3 +18,15 @@ TEST_OUT_EXTENSION :=
 
 # The number of tests to be performed
 TEST_NUMBER        := 
+
+# Runs processes at once on one prime cache, and how many at a time
+#   and how many times
+CACHE_TEST_SCRIPT = testConcurrentCache.sh
+CACHE_TEST_RUNS   = 6
+CACHE_TEST_ROUNDS = 12
+
+# Kernel microbenchmarks: source, program, and where "make bench" leaves
+#   the results, as JSON
+BENCH_FILE   = tools/bench.cpp
+BENCH_TARGET = $(BUILD)/eratosthenes-bench
+BENCH_OUTPUT = $(BUILD)/bench.json
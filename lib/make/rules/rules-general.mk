@@ -5,7 +5,7 @@
 #   on all of them.
 # ------------------------------------------------------------------------------
 
-.PHONY : clean unitTest perfTest
+.PHONY : clean library unitTest perfTest cacheTest bench
 
 # The --parents switch here allows to automatically create parent directories when needed.
 $(OBJECT_MOD_DIRS) ::
@@ -11,6 +11,16 @@ $(TARGET) : $(TARGET_DEPENDENCIES)
 	@$(LINK_CODE)
 	$(info Done.)
 
+# Archives the objects into a static library, for programs that
+#   embed the sieve (see Interface/library.hpp).
+library : $(LIBRARY)
+
+$(LIBRARY) : $(LIBRARY_DEPENDENCIES)
+	$(info Archiving library...)
+	@rm -f $@
+	@$(ARCHIVE_CODE)
+	$(info Done.)
+
 # Compiles objects.
 $(BUILD_MAIN)/%$(OBJECT_EXTENSION) :: $(APPLIANCE_MAIN)/%$(APP_EXTENSION) $(HEADER_MAIN)/%$(HEADER_EXTENSION)
 	$(info $@)
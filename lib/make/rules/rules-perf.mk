@@ -8,3 +8,20 @@
 # Then measures times to local csv file
 perfTest :: $(TARGET)
 	@bash $(TEST_SCRIPT) $(TEST_STEM) $(TEST_IN_EXTENSION) $(TEST_OUT_EXTENSION) $(TEST_NUMBER)
+
+# Checks that processes sharing a prime cache all get the right
+#   primes
+cacheTest :: $(TARGET)
+	@bash $(CACHE_TEST_SCRIPT) $(CACHE_TEST_RUNS) $(CACHE_TEST_ROUNDS)
+
+# Times the hot kernels of the sieve on their own, and saves the
+#   summary as JSON. Options go to the program through BENCH_ARGS, e.g.
+#   make bench BENCH_ARGS="--window-bytes=32768 --reps=1000"
+bench :: $(BENCH_TARGET)
+	@./$(BENCH_TARGET) $(BENCH_ARGS) > $(BENCH_OUTPUT)
+	@cat $(BENCH_OUTPUT)
+
+$(BENCH_TARGET) : $(BENCH_DEPENDENCIES)
+	$(info Linking bench...)
+	@$(BENCH_LINK_CODE)
+	$(info Done.)
@@ -16,9 +16,19 @@ OBJECT_MAIN_FILES := $(patsubst $(APPLIANCE_MAIN)%$(APP_EXTENSION), $(BUILD_MAIN
 # Compilation code for each object file
 COMPIL_OBJECT_CODE_MAIN = $(CXX) $(FLAGS) -I $(HEADER_MAIN) -c $< -o $@
 
+# Archiving code
+ARCHIVE_CODE = $(AR) rcs $@ $(OBJECT_MAIN_FILES)
+
 # Linking code
 LINK_CODE = $(CXX) $(FLAGS) -I $(HEADER_MAIN) $(OBJECT_MAIN_FILES) $(MAIN_FILE) -o $@
 
+# Linking code of the kernel microbenchmarks
+BENCH_LINK_CODE = $(CXX) $(FLAGS) -I $(HEADER_MAIN) $(OBJECT_MAIN_FILES) $(BENCH_FILE) -o $@
+
 BUILD_MODS_MAIN := $(patsubst %, $(BUILD_MAIN)/%, $(MODULES))
 
 TARGET_DEPENDENCIES := $(MAIN_FILE) $(HEADER_MAIN_FILES) $(APPLIANCE_MAIN_FILES) $(BUILD_MODS_MAIN) $(OBJECT_MAIN_FILES)
+
+LIBRARY_DEPENDENCIES := $(HEADER_MAIN_FILES) $(APPLIANCE_MAIN_FILES) $(BUILD_MODS_MAIN) $(OBJECT_MAIN_FILES)
+
+BENCH_DEPENDENCIES := $(BENCH_FILE) $(LIBRARY_DEPENDENCIES)
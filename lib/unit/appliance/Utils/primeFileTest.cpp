@@ -0,0 +1,139 @@
+//===----------------------------------------------------------===//
+// Utils module (unit tests)
+//
+// File purpose: implementation of class ~primeFileTest~. See header
+// file for more detail.
+//===----------------------------------------------------------===//
+
+#include "Utils/primeFileTest.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace Utils {
+
+namespace {
+
+const char* getFormatName(const primeFile::format fmt)
+{
+  return fmt == primeFile::format::varint ? "varint" : "bitmap";
+}
+
+}
+
+constexpr uint64_t primeFileTest::krightLim;
+
+void primeFileTest::run() noexcept(false)
+{
+  for (const primeFile::format fmt : {primeFile::format::varint,
+                                      primeFile::format::bitmap}) {
+    testRoundTrip(fmt);
+    testCorruptCount(fmt);
+    testTruncatedBody(fmt);
+  }
+}
+
+void primeFileTest::testRoundTrip(const primeFile::format fmt)
+  noexcept(false)
+{
+  const string path = writeFile(fmt);
+  primeFile::header h;
+  const vector<uint64_t> primes = primeFile::read(path, &h);
+  unlink(path.c_str());
+
+  if (primes != getPrimes() || h.fmt != fmt || h.leftLim != 0 ||
+      h.rightLim != krightLim || h.numPrimes != primes.size()) {
+    throw runtime_error{string{"round trip of a "} +
+                        getFormatName(fmt) + " file"};
+  }
+}
+
+void primeFileTest::testCorruptCount(const primeFile::format fmt)
+  noexcept(false)
+{
+  const string path = writeFile(fmt);
+  {
+    // The count sits at the end of the header.
+    fstream fs(path, ios::binary | ios::in | ios::out);
+    const uint64_t numPrimes = uint64_t{1} << 60;
+    fs.seekp(24);
+    fs.write(reinterpret_cast<const char*>(&numPrimes),
+             sizeof(numPrimes));
+  }
+  expectReadError(path, string{"corrupt count in a "} +
+                  getFormatName(fmt) + " file");
+}
+
+void primeFileTest::testTruncatedBody(const primeFile::format fmt)
+  noexcept(false)
+{
+  const string path = writeFile(fmt);
+  if (truncate(path.c_str(), 32 + 10) != 0) {
+    unlink(path.c_str());
+    throw runtime_error{"could not truncate " + path};
+  }
+  expectReadError(path, string{"truncated "} + getFormatName(fmt) +
+                  " file");
+}
+
+vector<uint64_t> primeFileTest::getPrimes()
+{
+  vector<uint64_t> primes;
+  for (uint64_t n = 2; n <= krightLim; ++n) {
+    bool isPrime = true;
+    for (uint64_t d = 2; d * d <= n && isPrime; ++d) {
+      isPrime = n % d != 0;
+    }
+    if (isPrime) {
+      primes.push_back(n);
+    }
+  }
+  return primes;
+}
+
+string primeFileTest::writeFile(const primeFile::format fmt)
+  noexcept(false)
+{
+  char path[] = "/tmp/eratosthenes-sieve-unitXXXXXX";
+  const int fd = mkstemp(path);
+  if (fd < 0) {
+    throw runtime_error{"could not create a temporary file"};
+  }
+  close(fd);
+
+  ofstream ofs(path, ios::binary | ios::trunc);
+  primeFile::write(ofs, fmt, 0, krightLim, getPrimes());
+  return path;
+}
+
+void primeFileTest::expectReadError(const string& path,
+                                    const string& what)
+  noexcept(false)
+{
+  string failure;
+  try {
+    primeFile::read(path);
+    failure = what + " was read";
+  }
+  catch (runtime_error& e) {
+    if (strncmp(e.what(), path.c_str(), path.size()) != 0) {
+      failure = what + ": unexpected error '" + e.what() + '\'';
+    }
+  }
+  catch (exception& e) {
+    failure = what + ": unexpected error '" + e.what() + '\'';
+  }
+  unlink(path.c_str());
+
+  if (!failure.empty()) {
+    throw runtime_error{failure};
+  }
+}
+
+}
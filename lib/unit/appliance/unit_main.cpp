@@ -0,0 +1,43 @@
+//===----------------------------------------------------------===//
+// File purpose: main function of the unit tests (make unitTest).
+//
+// Description: runs the tests of each class in turn, and reports
+// the ones that fail. The exit status is not zero if any of them
+// did.
+//===----------------------------------------------------------===//
+
+#include "Utils/primeFileTest.hpp"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+struct unitTest {
+  const char* name;
+  void (*run)();
+};
+
+const unitTest ktests[] = {
+  {"primeFile", Utils::primeFileTest::run}
+};
+
+}
+
+int main()
+{
+  int numFailed = 0;
+  for (const unitTest& test : ktests) {
+    try {
+      test.run();
+      cout << test.name << ": ok\n";
+    }
+    catch (std::exception& e) {
+      cout << test.name << ": FAILED (" << e.what() << ")\n";
+      ++numFailed;
+    }
+  }
+  return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+//===----------------------------------------------------------===//
+// Utils module (unit tests)
+//
+// File purpose: declaration of class ~primeFileTest~.
+//
+// Description: writes small prime files, in both formats, and reads
+// them back, whole and damaged. A damaged file must fail with the
+// reader's own error, whatever its header claims.
+//===----------------------------------------------------------===//
+
+#ifndef PRIMEFILETEST_H
+#define PRIMEFILETEST_H
+
+#include "Utils/primeFile.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Utils {
+
+class primeFileTest {
+public:
+  // Runs every test. Throws on the first one that fails.
+  static void run() noexcept(false);
+
+private:
+  static constexpr std::uint64_t krightLim = 1000;
+
+  static void testRoundTrip(const primeFile::format fmt)
+    noexcept(false);
+  // The header claims far more primes than the body could hold.
+  static void testCorruptCount(const primeFile::format fmt)
+    noexcept(false);
+  // The body is cut short, and the header still has the count of
+  // the whole file.
+  static void testTruncatedBody(const primeFile::format fmt)
+    noexcept(false);
+
+  // Primes of [0, krightLim].
+  static std::vector<std::uint64_t> getPrimes();
+  // Writes the primes of [0, krightLim] to a new temporary file, and
+  // returns its path.
+  static std::string writeFile(const primeFile::format fmt)
+    noexcept(false);
+  // Checks that reading ~path~ fails with the reader's own error.
+  static void expectReadError(const std::string& path,
+                              const std::string& what) noexcept(false);
+};
+
+}
+
+#endif
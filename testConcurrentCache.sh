@@ -0,0 +1,87 @@
+#!/bin/bash
+
+# Runs several processes at once against the same prime cache, all
+# over the same range, and checks that each of them gets the same
+# primes as a run without the cache. Then does it again on the cache
+# they left behind, which is only read. Each round takes the next
+# range.
+#
+# The runs start a little apart, so that some of them read blocks
+# that others are still sieving.
+
+usage() {
+    printf "Usage: <script> <num-runs> <num-rounds>"
+}
+
+execPath="./build/eratosthenes-sieve"
+
+# Right limit, mode and left limit of the runs of each round. Blocks
+# span 1966080 numbers, so the ranges have both whole blocks and
+# parts of blocks.
+ranges=("20000000 l 1000000" "3000000 c 0" "12000000 l 5000000"
+        "6000000 c 2500000")
+
+# Milliseconds between the starts of two runs.
+startDelay=10
+
+sieve() {
+    args=($1)
+    $execPath ${args[0]} ${args[1]} --left-limit=${args[2]} "${@:2}" |
+        md5sum
+}
+
+checkRound() {
+    numRuns=$1
+    range=$2
+    cachePath=$3
+    outDir=$4
+
+    for i in `seq 1 $numRuns`; do
+        { sleep $(( $i * $startDelay ))e-3
+          sieve "${ranges[$range]}" --cache=$cachePath > $outDir/$i.out
+        } &
+    done
+    wait
+
+    for i in `seq 1 $numRuns`; do
+        if ! cmp -s $outDir/$i.out $outDir/expected-$range.out; then
+            echo "Run $i over (${ranges[$range]}) differs"
+            return 1
+        fi
+    done
+}
+
+run() {
+    numRuns=$1
+    numRounds=$2
+
+    if [[ $numRuns = "" || $numRounds = "" ]]; then
+        echo $(usage)
+        exit 1
+    fi
+
+    outDir=$(mktemp -d)
+    trap "rm -rf $outDir" EXIT
+
+    for i in `seq 0 $(( ${#ranges[@]} - 1 ))`; do
+        sieve "${ranges[$i]}" > $outDir/expected-$i.out
+    done
+
+    for round in `seq 1 $numRounds`; do
+        range=$(( ($round - 1) % ${#ranges[@]} ))
+        rm -f $outDir/primes.cache
+        echo "Round $round: $numRuns runs over (${ranges[$range]})"
+        checkRound $numRuns $range $outDir/primes.cache $outDir ||
+            exit 1
+        checkRound $numRuns $range $outDir/primes.cache $outDir ||
+            exit 1
+    done
+
+    echo "All runs agree."
+}
+
+main() {
+    run $@
+}
+
+main $@
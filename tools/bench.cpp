@@ -0,0 +1,361 @@
+//===----------------------------------------------------------===//
+// File purpose: main function of the kernel microbenchmarks (make
+// bench).
+//
+// Description: times the hot kernels of eratSieve one by one, on a
+// single window, away from the rest of the run: how MPI spreads the
+// work, the output, and so on. Each kernel is run a few times to warm
+// up, then timed over a number of repetitions, and the summary of the
+// times goes to the standard output as JSON.
+//
+// Windows are sieved by the producers of the sieve engines, which
+// are what eratSieve runs, with one result for each engine, so the
+// engines can be compared. The small-prime loop of the eratosthenes
+// producer is timed on its own as well. Only fuseCurPrimesGlobal
+// talks to MPI, and it only makes sense with more than one process.
+//
+// Usage: <program> [--window-bytes=<b>] [--left-limit=<m>]
+//        [--reps=<r>] [--warmup=<w>] [--max-fuse-primes=<p>]
+//===----------------------------------------------------------===//
+
+#include "Alg/eratProducer.hpp"
+#include "Alg/eratSieve.hpp"
+#include "Alg/sieveEngine.hpp"
+#include "Alg/vectorSink.hpp"
+#include "DS/wheelSegment.hpp"
+#include "Utils/hwInfo.hpp"
+#include "Utils/num.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mpi.h"
+
+using namespace std;
+using namespace Utils;
+
+namespace {
+
+struct benchConfig {
+  size_t windowBytes = 0;
+  // Where the windows are. Far enough for the buckets to have work.
+  primeT leftLim = 1000000000000ULL;
+  unsigned reps = 200;
+  unsigned warmup = 20;
+  uint64_t maxFusePrimes = 1 << 22;
+};
+
+// Summary of the times of the repetitions of a kernel, in ns.
+struct stats {
+  double min;
+  double median;
+  double mean;
+  double stddev;
+  double max;
+};
+
+struct result {
+  string kernel;
+  // Engine that sieved the windows, if it matters.
+  string engine;
+  // What the kernel went through in each repetition, e.g. numbers
+  // or primes, and how many.
+  string unit;
+  uint64_t itemsPerRep;
+  stats ns;
+};
+
+// Calls ~fn~ warmup times, then times reps calls of it. ~fn~ gets
+// the index of the call, counting the warm-up ones.
+template <typename function>
+stats measure(const benchConfig& config, function fn)
+{
+  unsigned call = 0;
+  for (; call < config.warmup; ++call) {
+    fn(call);
+  }
+
+  vector<double> times(config.reps);
+  for (double& t : times) {
+    const auto t1 = chrono::steady_clock::now();
+    fn(call++);
+    const auto t2 = chrono::steady_clock::now();
+    t = chrono::duration<double, nano>(t2 - t1).count();
+  }
+
+  stats s;
+  sort(times.begin(), times.end());
+  s.min = times.front();
+  s.max = times.back();
+  s.median = times.size() % 2 == 1 ? times[times.size() / 2] :
+    (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2;
+  s.mean = 0;
+  for (const double t : times) {
+    s.mean += t;
+  }
+  s.mean /= times.size();
+  s.stddev = 0;
+  for (const double t : times) {
+    s.stddev += (t - s.mean) * (t - s.mean);
+  }
+  s.stddev = sqrt(s.stddev / times.size());
+  return s;
+}
+
+// Primes from 7 up to the square root of the last window that is
+// timed, which is what the producers are started with.
+vector<primeT> findSievingPrimes(const cacheInfo& cinfo,
+                                 const primeT rightLim)
+{
+  vector<primeT> primes;
+  Alg::sieveConfig sconfig;
+  sconfig.comm = MPI_COMM_SELF;
+  Alg::vectorSink<primeT> sink(&primes);
+  uint64_t numPrimes = 0;
+  Alg::eratSieve<primeT>(&cinfo, &sconfig, 7,
+                         num<primeT>::isqrt(rightLim), &sink,
+                         &numPrimes);
+  return primes;
+}
+
+void benchWindowKernels(const cacheInfo& cinfo,
+                        const benchConfig& config,
+                        vector<result>* results)
+{
+  typedef Alg::sieveEngine<primeT> engines;
+
+  DS::wheelSegment window(config.windowBytes);
+  const primeT span = window.span();
+  const primeT leftLim = config.leftLim
+    - config.leftLim % DS::wheelSegment::kwheelSz;
+  // Every call of findPrimesBetween takes the next window, so that
+  // the producers run as they do in a slab.
+  const primeT rightLim =
+    leftLim + (config.warmup + config.reps + 1) * span;
+  const vector<primeT> sievingPrimes =
+    findSievingPrimes(cinfo, rightLim);
+  vector<primeT> primes;
+  primes.reserve(window.numBits());
+
+  for (const string& name : engines::getNames()) {
+    const unique_ptr<Alg::segmentProducer<primeT>> producer =
+      engines::find(name).create(config.windowBytes);
+    producer->start(sievingPrimes.data(), sievingPrimes.size());
+    results->push_back(result{
+        "findPrimesBetween", name, "numbers", span,
+        measure(config, [&](const unsigned call) {
+            const primeT windowLeftLim = leftLim + call * span;
+            producer->produce(window, windowLeftLim,
+                              windowLeftLim + span);
+            primes.clear();
+            window.appendUnmarked(0, window.numBits(), windowLeftLim,
+                                  &primes);
+          })});
+  }
+
+  // The rest work on the window at leftLim, sieved for good.
+  Alg::eratProducer<primeT> erat(config.windowBytes);
+  erat.start(sievingPrimes.data(), sievingPrimes.size());
+  erat.produce(window, leftLim, leftLim + span);
+  const uint64_t numPrimes = window.countUnmarked(0, window.numBits());
+
+  results->push_back(result{
+      "allUnmarkedArePrimes", "", "primes", numPrimes,
+      measure(config, [&](const unsigned) {
+          primes.clear();
+          window.appendUnmarked(0, window.numBits(), leftLim, &primes);
+        })});
+
+  // Keeps the counts from being thrown away.
+  volatile uint64_t counted = 0;
+  results->push_back(result{
+      "countUnmarked", "", "numbers", span,
+      measure(config, [&](const unsigned) {
+          counted = window.countUnmarked(0, window.numBits());
+        })});
+
+  results->push_back(result{
+      "markSmallPrimes", "", "numbers", span,
+      measure(config, [&](const unsigned) {
+          erat.markSmallPrimes(window, leftLim, leftLim + span);
+        })});
+
+  results->push_back(result{
+      "presieveMarkWindow", "", "numbers", span,
+      measure(config, [&](const unsigned) {
+          window.presieve(leftLim);
+        })});
+
+  results->push_back(result{
+      "resetMarkWindow", "", "numbers", span,
+      measure(config, [&](const unsigned) {
+          window.reset();
+        })});
+}
+
+// The gather of fuseCurPrimesGlobal and waitCurPrimesFused, with
+// every process holding ~numPrimes~ primes.
+void benchFuse(const benchConfig& config, vector<result>* results)
+{
+  int myProcRank;
+  int commSz;
+  MPI_Comm_rank(MPI_COMM_WORLD, &myProcRank);
+  MPI_Comm_size(MPI_COMM_WORLD, &commSz);
+
+  for (uint64_t numPrimes = 1 << 10;
+       numPrimes <= config.maxFusePrimes; numPrimes *= 4) {
+    vector<primeT> primes(numPrimes, 1);
+    vector<uint64_t> sizes(commSz);
+    vector<int> counts(commSz);
+    vector<int> displs(commSz);
+    stats s = measure(config, [&](const unsigned) {
+        primes.resize(numPrimes);
+        MPI_Allgather(&numPrimes, 1, MPI_UINT64_T, sizes.data(), 1,
+                      MPI_UINT64_T, MPI_COMM_WORLD);
+        uint64_t totalSz = 0;
+        for (int i = 0; i < commSz; ++i) {
+          counts[i] = sizes[i];
+          displs[i] = totalSz;
+          totalSz += sizes[i];
+        }
+
+        MPI_Request request;
+        if (myProcRank == 0) {
+          primes.resize(totalSz);
+          MPI_Igatherv(MPI_IN_PLACE, 0, MPI_UINT64_T, primes.data(),
+                       counts.data(), displs.data(), MPI_UINT64_T, 0,
+                       MPI_COMM_WORLD, &request);
+        }
+        else {
+          MPI_Igatherv(primes.data(), counts[myProcRank],
+                       MPI_UINT64_T, nullptr, nullptr, nullptr,
+                       MPI_UINT64_T, 0, MPI_COMM_WORLD, &request);
+        }
+        MPI_Wait(&request, MPI_STATUS_IGNORE);
+      });
+    results->push_back(result{
+        "fuseCurPrimesGlobal", "", "primes per process", numPrimes,
+        s});
+  }
+}
+
+void setOption(const char* arg, benchConfig* config) noexcept(false)
+{
+  const string option{arg};
+  const size_t eqPos = option.find('=');
+  if (eqPos == string::npos) {
+    throw invalid_argument{
+      "Option '" + option + "' should be --<name>=<value>"};
+  }
+  const string name = option.substr(0, eqPos);
+  const char* value = arg + eqPos + 1;
+
+  if (name == "--window-bytes") {
+    config->windowBytes = num<size_t>::parseUnsigned(value);
+    num<size_t>::checkInRange(config->windowBytes, 1, 1 << 28);
+  }
+  else if (name == "--left-limit") {
+    config->leftLim = num<primeT>::parseUnsigned(value);
+    num<primeT>::checkInRange(config->leftLim, 0,
+                              1000000000000000000ULL);
+  }
+  else if (name == "--reps") {
+    config->reps = num<unsigned>::parseUnsigned(value);
+    num<unsigned>::checkInRange(config->reps, 1, 1 << 20);
+  }
+  else if (name == "--warmup") {
+    config->warmup = num<unsigned>::parseUnsigned(value);
+    num<unsigned>::checkInRange(config->warmup, 0, 1 << 20);
+  }
+  else if (name == "--max-fuse-primes") {
+    config->maxFusePrimes = num<uint64_t>::parseUnsigned(value);
+    num<uint64_t>::checkInRange(config->maxFusePrimes, 0, 1 << 28);
+  }
+  else {
+    throw invalid_argument{"Unknown option '" + name + '\''};
+  }
+}
+
+void printJSON(const cacheInfo& cinfo, const benchConfig& config,
+               const vector<result>& results)
+{
+  int commSz;
+  MPI_Comm_size(MPI_COMM_WORLD, &commSz);
+
+  cout << "{\n"
+       << "  \"config\": {\n"
+       << "    \"host\": \"" << hwInfo::getHostName() << "\",\n"
+       << "    \"l1DataCacheBytes\": " << cinfo.size << ",\n"
+       << "    \"windowBytes\": " << config.windowBytes << ",\n"
+       << "    \"leftLimit\": " << config.leftLim << ",\n"
+       << "    \"reps\": " << config.reps << ",\n"
+       << "    \"warmup\": " << config.warmup << ",\n"
+       << "    \"processes\": " << commSz << "\n"
+       << "  },\n"
+       << "  \"results\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const result& r = results[i];
+    cout << (i > 0 ? "," : "") << "\n"
+         << "    {\"kernel\": \"" << r.kernel << "\", ";
+    if (!r.engine.empty()) {
+      cout << "\"engine\": \"" << r.engine << "\", ";
+    }
+    cout << "\"unit\": \"" << r.unit << "\", "
+         << "\"itemsPerRep\": " << r.itemsPerRep << ",\n"
+         << "     \"ns\": {\"min\": " << r.ns.min
+         << ", \"median\": " << r.ns.median
+         << ", \"mean\": " << r.ns.mean
+         << ", \"stddev\": " << r.ns.stddev
+         << ", \"max\": " << r.ns.max << "},\n"
+         << "     \"itemsPerNs\": " << r.itemsPerRep / r.ns.median
+         << "}";
+  }
+  cout << "\n  ]\n}\n";
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+  int myProcRank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &myProcRank);
+
+  try {
+    benchConfig config;
+    for (int i = 1; i < argc; ++i) {
+      setOption(argv[i], &config);
+    }
+
+    cacheInfo cinfo;
+    hwInfo::fetchCacheInfo(&cinfo, LEVEL1, DATA_CACHE);
+    // The same default window as eratSieve.
+    if (config.windowBytes == 0) {
+      config.windowBytes = cinfo.size > 0 ? cinfo.size / 2 : 16384;
+    }
+
+    vector<result> results;
+    benchWindowKernels(cinfo, config, &results);
+    benchFuse(config, &results);
+    if (myProcRank == 0) {
+      printJSON(cinfo, config, results);
+    }
+  }
+  catch (std::exception& e) {
+    cerr << "Uncaught exception:\n"\
+      "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n"\
+         << e.what() << "\n"\
+      "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~\n";
+  }
+
+  MPI_Finalize();
+  return 0;
+}
@@ -20,7 +20,10 @@ using namespace std;
 
 int main(int argc, char** argv)
 {
-  MPI_Init(&argc, &argv);
+  // Only the main thread of each process talks to MPI. The threads
+  // of the sieve never do.
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
   try {
     Interface::init(argc, argv);
   }